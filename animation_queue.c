@@ -0,0 +1,279 @@
+#include "animation_queue.h"
+
+// Upper bound on commands run in one frame, so a flood of producers can't
+// blow the frame budget; the rest run on the following frames
+#define ANIMATION_QUEUE_MAX_PER_FRAME 1024
+// How long a backlog waits before its next batch, about one frame at 60 Hz
+#define ANIMATION_QUEUE_BACKLOG_DELAY_US (G_USEC_PER_SEC / 60)
+
+typedef enum {
+    COMMAND_STUB,
+    COMMAND_PULSE,
+    COMMAND_ROTATION_CYCLE,
+    COMMAND_PUSHBACK,
+    COMMAND_CAMERA,
+    COMMAND_CANCEL,
+    COMMAND_FUNC
+} CommandType;
+
+typedef struct _AnimationCommand AnimationCommand;
+
+struct _AnimationCommand {
+    AnimationCommand *next;
+    CommandType type;
+    GtkWidget *widget;
+    GtkWidget *slides;
+    gint y_position;
+    gdouble rotation;
+    guint duration_ms;
+    guint rotate_duration_ms;
+    AnimationKind kind;
+    AnimationQueueFunc func;
+    gpointer user_data;
+};
+
+// Intrusive multi-producer single-consumer queue (Vyukov). Producers only
+// swap head; the consumer owns tail. The stub node keeps the list non-empty
+// so producers never need to look at tail.
+//
+// The main thread is only woken when the queue goes from empty to
+// non-empty: the producer that sets wake_pending makes the drain source
+// ready, everyone else just links their command.
+struct _AnimationQueue {
+    AnimationCommand *head;
+    AnimationCommand *tail;
+    AnimationCommand stub;
+    GSource *source;
+    gint wake_pending;
+};
+
+// Static helper functions
+static AnimationCommand *command_new(CommandType type, GtkWidget *widget);
+static void command_free(AnimationCommand *command);
+static void link_command(AnimationQueue *queue, AnimationCommand *command);
+static void push_command(AnimationQueue *queue, AnimationCommand *command);
+static AnimationCommand *pop_command(AnimationQueue *queue);
+static void run_command(AnimationCommand *command);
+static gboolean dispatch_queue_source(GSource *source, GSourceFunc callback, gpointer user_data);
+static gboolean on_queue_ready(gpointer user_data);
+
+// Never ready on its own; producers make it ready with a ready time
+static GSourceFuncs queue_source_funcs = {
+    NULL,
+    NULL,
+    dispatch_queue_source,
+    NULL,
+    NULL,
+    NULL
+};
+
+AnimationQueue *animation_queue_new(void) {
+    AnimationQueue *queue = g_new0(AnimationQueue, 1);
+    queue->stub.type = COMMAND_STUB;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+
+    // Ahead of GTK's layout and paint, so commands pushed before a frame
+    // start animating in that frame
+    GMainContext *context = g_main_context_ref_thread_default();
+    queue->source = g_source_new(&queue_source_funcs, sizeof(GSource));
+    g_source_set_priority(queue->source, G_PRIORITY_HIGH_IDLE);
+    g_source_set_callback(queue->source, on_queue_ready, queue, NULL);
+    g_source_set_name(queue->source, "animation queue");
+    g_source_attach(queue->source, context);
+    g_main_context_unref(context);
+
+    return queue;
+}
+
+void animation_queue_free(AnimationQueue *queue) {
+    if (queue) {
+        AnimationCommand *command;
+
+        g_source_destroy(queue->source);
+        g_source_unref(queue->source);
+        while ((command = pop_command(queue))) {
+            command_free(command);
+        }
+        g_free(queue);
+    }
+}
+
+static AnimationCommand *command_new(CommandType type, GtkWidget *widget) {
+    AnimationCommand *command = g_new0(AnimationCommand, 1);
+    command->type = type;
+    // Atomic refcount, safe off the main thread
+    command->widget = widget ? g_object_ref(widget) : NULL;
+    return command;
+}
+
+static void command_free(AnimationCommand *command) {
+    // Runs on the main thread, so a last unref here is fine for widgets
+    g_clear_object(&command->widget);
+    g_clear_object(&command->slides);
+    g_free(command);
+}
+
+static void link_command(AnimationQueue *queue, AnimationCommand *command) {
+    g_atomic_pointer_set(&command->next, NULL);
+    AnimationCommand *prev = g_atomic_pointer_exchange(&queue->head, command);
+    // Between the exchange and this store the consumer sees a gap and
+    // simply stops; the command is picked up on the next drain
+    g_atomic_pointer_set(&prev->next, command);
+}
+
+static void push_command(AnimationQueue *queue, AnimationCommand *command) {
+    link_command(queue, command);
+    // Only after linking: a drain that already cleared the flag is either
+    // still running and sees the command, or is woken again by this push
+    if (g_atomic_int_compare_and_exchange(&queue->wake_pending, FALSE, TRUE)) {
+        g_source_set_ready_time(queue->source, 0);
+    }
+}
+
+static AnimationCommand *pop_command(AnimationQueue *queue) {
+    AnimationCommand *tail = queue->tail;
+    AnimationCommand *next = g_atomic_pointer_get(&tail->next);
+
+    if (tail == &queue->stub) {
+        if (!next) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = g_atomic_pointer_get(&tail->next);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    // tail is the last linked node; a producer may be mid-push
+    if (tail != g_atomic_pointer_get(&queue->head)) {
+        return NULL;
+    }
+
+    // Re-insert the stub so tail can be handed out
+    link_command(queue, &queue->stub);
+    next = g_atomic_pointer_get(&tail->next);
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+void animation_queue_push_pulse(AnimationQueue *queue, GtkWidget *widget) {
+    push_command(queue, command_new(COMMAND_PULSE, widget));
+}
+
+void animation_queue_push_rotation_cycle(AnimationQueue *queue, GtkWidget *widget,
+                                         guint duration_ms) {
+    AnimationCommand *command = command_new(COMMAND_ROTATION_CYCLE, widget);
+    command->duration_ms = duration_ms;
+    push_command(queue, command);
+}
+
+void animation_queue_push_pushback(AnimationQueue *queue, GtkWidget *widget,
+                                   gdouble rotation, guint duration_ms) {
+    AnimationCommand *command = command_new(COMMAND_PUSHBACK, widget);
+    command->rotation = rotation;
+    command->duration_ms = duration_ms;
+    push_command(queue, command);
+}
+
+void animation_queue_push_camera(AnimationQueue *queue, GtkWidget *widget, GtkWidget *slides,
+                                 gint y_position, gdouble rotation,
+                                 guint move_duration, guint rotate_duration) {
+    AnimationCommand *command = command_new(COMMAND_CAMERA, widget);
+    command->slides = g_object_ref(slides);
+    command->y_position = y_position;
+    command->rotation = rotation;
+    command->duration_ms = move_duration;
+    command->rotate_duration_ms = rotate_duration;
+    push_command(queue, command);
+}
+
+void animation_queue_push_cancel(AnimationQueue *queue, GtkWidget *widget, AnimationKind kind) {
+    AnimationCommand *command = command_new(COMMAND_CANCEL, widget);
+    command->kind = kind;
+    push_command(queue, command);
+}
+
+void animation_queue_push_func(AnimationQueue *queue, AnimationQueueFunc func, gpointer user_data) {
+    AnimationCommand *command = command_new(COMMAND_FUNC, NULL);
+    command->func = func;
+    command->user_data = user_data;
+    push_command(queue, command);
+}
+
+static void run_command(AnimationCommand *command) {
+    switch (command->type) {
+        case COMMAND_PULSE: {
+            AnimationParams params = {
+                .widget = command->widget,
+                .start_value = 1.0,
+                .end_value = 0.3,
+                .duration_ms = 500
+            };
+            animate_property(&params, "opacity");
+            break;
+        }
+        case COMMAND_ROTATION_CYCLE:
+            start_rotation_cycle(command->widget, command->duration_ms);
+            break;
+        case COMMAND_PUSHBACK:
+            rotate_with_pushback(command->widget, command->rotation, command->duration_ms);
+            break;
+        case COMMAND_CAMERA:
+            move_and_rotate(command->widget, command->slides, command->y_position,
+                            command->rotation, command->duration_ms,
+                            command->rotate_duration_ms);
+            break;
+        case COMMAND_CANCEL:
+            animation_cancel(command->widget, command->kind);
+            break;
+        case COMMAND_FUNC:
+            command->func(command->user_data);
+            break;
+        case COMMAND_STUB:
+        default:
+            break;
+    }
+}
+
+guint animation_queue_drain(AnimationQueue *queue) {
+    AnimationCommand *command;
+    guint count = 0;
+
+    while (count < ANIMATION_QUEUE_MAX_PER_FRAME && (command = pop_command(queue))) {
+        run_command(command);
+        command_free(command);
+        count++;
+    }
+
+    return count;
+}
+
+static gboolean dispatch_queue_source(GSource *source, GSourceFunc callback, gpointer user_data) {
+    g_source_set_ready_time(source, -1);
+    return callback(user_data);
+}
+
+static gboolean on_queue_ready(gpointer user_data) {
+    AnimationQueue *queue = (AnimationQueue *)user_data;
+
+    // Cleared before draining, so a push racing with the drain wakes us again
+    g_atomic_int_set(&queue->wake_pending, FALSE);
+
+    if (animation_queue_drain(queue) == ANIMATION_QUEUE_MAX_PER_FRAME &&
+        g_atomic_int_compare_and_exchange(&queue->wake_pending, FALSE, TRUE)) {
+        // Backlog: let a frame paint before the next batch
+        g_source_set_ready_time(queue->source,
+                                g_get_monotonic_time() + ANIMATION_QUEUE_BACKLOG_DELAY_US);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
@@ -0,0 +1,45 @@
+#ifndef ANIMATION_QUEUE_H
+#define ANIMATION_QUEUE_H
+
+#include "animations.h"
+
+// Thread-safe front end for animations.c.
+//
+// Any thread may push commands; pushing is a single atomic exchange, never
+// blocks and never touches GTK. A push onto an empty queue wakes the main
+// loop, which drains the queue from a high priority idle source (or
+// explicitly with animation_queue_drain()) and runs the commands in push
+// order. Commands from one producer always run in the order that producer
+// pushed them. Draining doesn't depend on any widget being mapped, and an
+// empty queue costs nothing: no frame clock is kept running for it.
+//
+// Widgets passed in must stay alive for the duration of the push call; the
+// queue holds its own reference until the command has run.
+
+typedef void (*AnimationQueueFunc)(gpointer user_data);
+
+typedef struct _AnimationQueue AnimationQueue;
+
+// Main thread only; drains on the thread-default main context
+AnimationQueue *animation_queue_new(void);
+// Main thread only, once no producer can push any more; pending commands
+// are dropped
+void animation_queue_free(AnimationQueue *queue);
+
+// Producers, callable from any thread
+void animation_queue_push_pulse(AnimationQueue *queue, GtkWidget *widget);
+void animation_queue_push_rotation_cycle(AnimationQueue *queue, GtkWidget *widget,
+                                         guint duration_ms);
+void animation_queue_push_pushback(AnimationQueue *queue, GtkWidget *widget,
+                                   gdouble rotation, guint duration_ms);
+void animation_queue_push_camera(AnimationQueue *queue, GtkWidget *widget, GtkWidget *slides,
+                                 gint y_position, gdouble rotation,
+                                 guint move_duration, guint rotate_duration);
+void animation_queue_push_cancel(AnimationQueue *queue, GtkWidget *widget, AnimationKind kind);
+// Runs func(user_data) on the main thread at the next drain
+void animation_queue_push_func(AnimationQueue *queue, AnimationQueueFunc func, gpointer user_data);
+
+// Main thread: run pending commands now, returns how many ran
+guint animation_queue_drain(AnimationQueue *queue);
+
+#endif
@@ -1,6 +1,38 @@
 #include "animations.h"
+#include "layer.h"
 #include <math.h>
 
+// Quality policy tuning
+#define QUALITY_DEFAULT_REFRESH_US 16667  // used when the clock has no refresh info
+#define QUALITY_EWMA_WEIGHT 0.1
+#define QUALITY_SLOW_FACTOR 1.5           // average above this x budget is "slow"
+#define QUALITY_FAST_FACTOR 1.15          // average below this x budget is "fast"
+#define QUALITY_DEGRADE_FRAMES 15         // consecutive slow frames before degrading
+#define QUALITY_RECOVER_FRAMES 180        // consecutive fast frames before recovering
+#define QUALITY_MIN_DWELL_US (1 * G_USEC_PER_SEC)
+#define QUALITY_IDLE_GAP_US (250 * 1000)  // longer gaps are the clock idling, not misses
+
+// Widget data keys the running contexts are stored under
+#define PULSE_CTX_KEY "pulse_ctx"
+#define ROTATION_CTX_KEY "rotation_ctx"
+#define CAMERA_CTX_KEY "camera_ctx"
+
+typedef struct {
+    AnimationQuality level;
+    GdkFrameClock *clock; // only compared, never dereferenced
+    gint64 frame_counter;
+    gint64 frame_time;
+    double avg_interval_us;
+    guint slow_frames;
+    guint fast_frames;
+    gint64 level_since;
+    guint trackers; // Animations currently sampling frames
+    AnimationPolicyLogFunc log_func;
+    gpointer log_data;
+} QualityMonitor;
+
+static QualityMonitor quality = { .level = ANIMATION_QUALITY_FULL };
+
 // Animation context for custom animations
 typedef struct {
     GtkWidget *widget;
@@ -11,6 +43,8 @@ typedef struct {
     gboolean is_continuous;
     GtkCssProvider *provider;
     gint cycle_count; // Track rotation cycles
+    guint tick_id;
+    guint tick_count;
 } RotationContext;
 
 typedef struct {
@@ -25,6 +59,8 @@ typedef struct {
     GtkCssProvider *provider;
     gint phase; // 0=fade in, 1=scale up, 2=fade out, 3=scale down, 4=interval
     gint64 phase_start_time;
+    guint tick_id;
+    gboolean suspended; // Held at rest while quality is reduced
 } PulseContext;
 
 typedef struct {
@@ -42,6 +78,9 @@ typedef struct {
     guint timeout_id;
     GtkCssProvider *move_provider;
     GtkCssProvider *rotate_provider;
+    guint tick_id;
+    guint tick_count;
+    gboolean layers_active; // Layers among the moved widgets are caching
 } CameraContext;
 
 // Static helper functions
@@ -51,13 +90,21 @@ static gboolean update_camera_timeout(gpointer user_data);
 static void cleanup_rotation_context(RotationContext *ctx);
 static void cleanup_pulse_context(PulseContext *ctx);
 static void cleanup_camera_context(CameraContext *ctx);
+static gboolean quality_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data);
+static void quality_set_level(AnimationQuality level, const char *reason);
+static void quality_reset(const char *reason);
+static gboolean quality_throttled(guint *tick_count);
+static void start_tracking(GtkWidget *widget, guint *tick_id);
+static void stop_tracking(GtkWidget *widget, guint *tick_id);
+static void set_camera_layers_active(CameraContext *ctx, gboolean active);
+static void release_camera_widgets(CameraContext *ctx);
 
 void animate_property(AnimationParams *params, const char *property) {
     if (g_strcmp0(property, "opacity") == 0) {
         // Stop any existing pulse animation
-        PulseContext *existing = g_object_get_data(G_OBJECT(params->widget), "pulse_ctx");
+        PulseContext *existing = g_object_get_data(G_OBJECT(params->widget), PULSE_CTX_KEY);
         if (existing) {
-            g_object_set_data(G_OBJECT(params->widget), "pulse_ctx", NULL);
+            g_object_set_data(G_OBJECT(params->widget), PULSE_CTX_KEY, NULL);
         }
         
         PulseContext *ctx = g_new0(PulseContext, 1);
@@ -72,10 +119,11 @@ void animate_property(AnimationParams *params, const char *property) {
         ctx->phase_start_time = ctx->start_time;
         ctx->provider = gtk_css_provider_new();
         
-        g_object_set_data_full(G_OBJECT(params->widget), "pulse_ctx", ctx,
+        g_object_set_data_full(G_OBJECT(params->widget), PULSE_CTX_KEY, ctx,
                               (GDestroyNotify)cleanup_pulse_context);
         
         ctx->timeout_id = g_timeout_add(16, update_pulse_timeout, ctx);
+        start_tracking(params->widget, &ctx->tick_id);
         g_print("Starting looping pulse animation\n");
     } else {
         g_warning("Property '%s' is not supported for animation", property);
@@ -86,9 +134,9 @@ void start_rotation_cycle(GtkWidget *widget, guint duration_ms) {
     g_print("Starting continuous rotation cycle\n");
     
     // Clean up any existing animation on this widget
-    RotationContext *existing = g_object_get_data(G_OBJECT(widget), "rotation_ctx");
+    RotationContext *existing = g_object_get_data(G_OBJECT(widget), ROTATION_CTX_KEY);
     if (existing) {
-        g_object_set_data(G_OBJECT(widget), "rotation_ctx", NULL);
+        g_object_set_data(G_OBJECT(widget), ROTATION_CTX_KEY, NULL);
     }
     
     // Reset widget rotation first
@@ -103,19 +151,20 @@ void start_rotation_cycle(GtkWidget *widget, guint duration_ms) {
     ctx->cycle_count = 0;
     ctx->provider = gtk_css_provider_new();
     
-    g_object_set_data_full(G_OBJECT(widget), "rotation_ctx", ctx,
+    g_object_set_data_full(G_OBJECT(widget), ROTATION_CTX_KEY, ctx,
                           (GDestroyNotify)cleanup_rotation_context);
     
     ctx->timeout_id = g_timeout_add(16, update_rotation_timeout, ctx);
+    start_tracking(widget, &ctx->tick_id);
 }
 
 void rotate_with_pushback(GtkWidget *widget, gdouble rotation, guint duration_ms) {
     g_print("Starting pushback rotation\n");
     
     // Clean up any existing animation
-    RotationContext *existing = g_object_get_data(G_OBJECT(widget), "rotation_ctx");
+    RotationContext *existing = g_object_get_data(G_OBJECT(widget), ROTATION_CTX_KEY);
     if (existing) {
-        g_object_set_data(G_OBJECT(widget), "rotation_ctx", NULL);
+        g_object_set_data(G_OBJECT(widget), ROTATION_CTX_KEY, NULL);
     }
     
     RotationContext *ctx = g_new0(RotationContext, 1);
@@ -126,10 +175,11 @@ void rotate_with_pushback(GtkWidget *widget, gdouble rotation, guint duration_ms
     ctx->is_continuous = FALSE;
     ctx->provider = gtk_css_provider_new();
     
-    g_object_set_data_full(G_OBJECT(widget), "rotation_ctx", ctx,
+    g_object_set_data_full(G_OBJECT(widget), ROTATION_CTX_KEY, ctx,
                           (GDestroyNotify)cleanup_rotation_context);
     
     ctx->timeout_id = g_timeout_add(16, update_rotation_timeout, ctx);
+    start_tracking(widget, &ctx->tick_id);
 }
 
 void move_and_rotate(GtkWidget *widget, GtkWidget *slides, 
@@ -148,15 +198,17 @@ void move_and_rotate(GtkWidget *widget, GtkWidget *slides,
     }
     
     // Clean up any existing camera animation
-    CameraContext *existing = g_object_get_data(G_OBJECT(widget), "camera_ctx");
+    CameraContext *existing = g_object_get_data(G_OBJECT(widget), CAMERA_CTX_KEY);
     if (existing) {
-        g_object_set_data(G_OBJECT(widget), "camera_ctx", NULL);
+        g_object_set_data(G_OBJECT(widget), CAMERA_CTX_KEY, NULL);
     }
     
     CameraContext *ctx = g_new0(CameraContext, 1);
     ctx->camera_widget = widget;
-    ctx->slides_widget = slides;
-    ctx->main_container = main_container;
+    // The context lives on the camera widget and outlasts neither of these
+    // otherwise; held until the move finishes
+    ctx->slides_widget = slides ? g_object_ref(slides) : NULL;
+    ctx->main_container = main_container ? g_object_ref(main_container) : NULL;
     ctx->start_y = 0;
     ctx->target_y = y_position;
     ctx->start_rotation = 0.0;
@@ -168,17 +220,37 @@ void move_and_rotate(GtkWidget *widget, GtkWidget *slides,
     ctx->move_provider = gtk_css_provider_new();
     ctx->rotate_provider = gtk_css_provider_new();
     
-    g_object_set_data_full(G_OBJECT(widget), "camera_ctx", ctx,
+    g_object_set_data_full(G_OBJECT(widget), CAMERA_CTX_KEY, ctx,
                           (GDestroyNotify)cleanup_camera_context);
     
+    // Only transforms change while the camera moves, so opted-in layers
+    // can composite a cached texture instead of re-snapshotting
+    set_camera_layers_active(ctx, TRUE);
+    
     ctx->timeout_id = g_timeout_add(16, update_camera_timeout, ctx);
+    start_tracking(widget, &ctx->tick_id);
+}
+
+void animation_cancel(GtkWidget *widget, AnimationKind kind) {
+    // Dropping the context runs its cleanup, which stops the timer
+    switch (kind) {
+        case ANIMATION_KIND_PULSE:
+            g_object_set_data(G_OBJECT(widget), PULSE_CTX_KEY, NULL);
+            break;
+        case ANIMATION_KIND_ROTATION:
+            g_object_set_data(G_OBJECT(widget), ROTATION_CTX_KEY, NULL);
+            break;
+        case ANIMATION_KIND_CAMERA:
+            g_object_set_data(G_OBJECT(widget), CAMERA_CTX_KEY, NULL);
+            break;
+    }
 }
 
 void reset_rotation(GtkWidget *widget) {
     g_print("Resetting rotation\n");
     
     // Clean up any existing animation
-    g_object_set_data(G_OBJECT(widget), "rotation_ctx", NULL);
+    g_object_set_data(G_OBJECT(widget), ROTATION_CTX_KEY, NULL);
     
     GtkCssProvider *provider = gtk_css_provider_new();
     gtk_css_provider_load_from_string(provider, "* { transform: rotate(0deg); transition: none; }");
@@ -233,6 +305,8 @@ static gboolean update_rotation_timeout(gpointer user_data) {
                 GTK_STYLE_PROVIDER_PRIORITY_APPLICATION + 1);
             
             g_print("Pushback rotation complete\n");
+            ctx->timeout_id = 0;
+            stop_tracking(ctx->widget, &ctx->tick_id);
             return G_SOURCE_REMOVE;
         }
         
@@ -243,6 +317,10 @@ static gboolean update_rotation_timeout(gpointer user_data) {
         ctx->current_rotation = eased_progress * 360.0;
     }
     
+    if (quality_throttled(&ctx->tick_count)) {
+        return G_SOURCE_CONTINUE;
+    }
+    
     char *css = g_strdup_printf("* { transform: rotate(%.2fdeg); transition: none; }", 
                                ctx->current_rotation);
     gtk_css_provider_load_from_string(ctx->provider, css);
@@ -277,6 +355,22 @@ static gboolean update_pulse_timeout(gpointer user_data) {
         }
     }
     
+    if (quality.level >= ANIMATION_QUALITY_REDUCED) {
+        // Pulse is decorative: park the widget at rest and stop restyling
+        // it every tick until frames are on time again
+        if (!ctx->suspended) {
+            ctx->suspended = TRUE;
+            gtk_css_provider_load_from_string(ctx->provider,
+                "* { opacity: 1.00; transform: scale(1.00); transition: none; }");
+            gtk_style_context_add_provider(
+                gtk_widget_get_style_context(ctx->widget),
+                GTK_STYLE_PROVIDER(ctx->provider),
+                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION + 1);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+    ctx->suspended = FALSE;
+    
     double current_opacity, current_scale;
     
     switch (ctx->phase) {
@@ -331,9 +425,10 @@ static gboolean update_camera_timeout(gpointer user_data) {
     
     gboolean move_complete = move_progress >= 1.0;
     gboolean rotate_complete = rotate_progress >= 1.0;
+    gboolean throttled = quality_throttled(&ctx->tick_count);
     
     // Update camera position (viewport movement)
-    if (!move_complete) {
+    if (!move_complete && !throttled) {
         // Ease in-out for smooth movement
         double eased_move = move_progress < 0.5 ? 
             2 * move_progress * move_progress : 
@@ -357,7 +452,7 @@ static gboolean update_camera_timeout(gpointer user_data) {
     }
     
     // Update slides rotation
-    if (!rotate_complete) {
+    if (!rotate_complete && !throttled) {
         // Sine ease in-out
         double eased_rotate = sin(rotate_progress * M_PI / 2);
         double current_rotation = ctx->start_rotation + (ctx->target_rotation - ctx->start_rotation) * eased_rotate;
@@ -375,6 +470,12 @@ static gboolean update_camera_timeout(gpointer user_data) {
     
     if (move_complete && rotate_complete) {
         g_print("Camera movement complete\n");
+        ctx->timeout_id = 0;
+        stop_tracking(ctx->camera_widget, &ctx->tick_id);
+        set_camera_layers_active(ctx, FALSE);
+        // main_container is an ancestor of the camera widget, don't keep
+        // that cycle alive once nothing is animating
+        release_camera_widgets(ctx);
         return G_SOURCE_REMOVE;
     }
     
@@ -386,6 +487,7 @@ static void cleanup_rotation_context(RotationContext *ctx) {
         if (ctx->timeout_id > 0) {
             g_source_remove(ctx->timeout_id);
         }
+        stop_tracking(ctx->widget, &ctx->tick_id);
         if (ctx->provider) {
             g_object_unref(ctx->provider);
         }
@@ -398,6 +500,7 @@ static void cleanup_pulse_context(PulseContext *ctx) {
         if (ctx->timeout_id > 0) {
             g_source_remove(ctx->timeout_id);
         }
+        stop_tracking(ctx->widget, &ctx->tick_id);
         if (ctx->provider) {
             g_object_unref(ctx->provider);
         }
@@ -410,6 +513,9 @@ static void cleanup_camera_context(CameraContext *ctx) {
         if (ctx->timeout_id > 0) {
             g_source_remove(ctx->timeout_id);
         }
+        stop_tracking(ctx->camera_widget, &ctx->tick_id);
+        set_camera_layers_active(ctx, FALSE);
+        release_camera_widgets(ctx);
         if (ctx->move_provider) {
             g_object_unref(ctx->move_provider);
         }
@@ -419,3 +525,172 @@ static void cleanup_camera_context(CameraContext *ctx) {
         g_free(ctx);
     }
 }
+
+static void set_camera_layers_active(CameraContext *ctx, gboolean active) {
+    if (ctx->layers_active == active) {
+        return;
+    }
+    ctx->layers_active = active;
+    
+    GtkWidget *widgets[] = { ctx->slides_widget, ctx->main_container };
+    for (gsize i = 0; i < G_N_ELEMENTS(widgets); i++) {
+        if (widgets[i] && PRESENT_IS_LAYER(widgets[i])) {
+            if (active) {
+                present_layer_begin(PRESENT_LAYER(widgets[i]));
+            } else {
+                present_layer_end(PRESENT_LAYER(widgets[i]));
+            }
+        }
+    }
+}
+
+static void release_camera_widgets(CameraContext *ctx) {
+    g_clear_object(&ctx->slides_widget);
+    g_clear_object(&ctx->main_container);
+}
+
+// ===== Adaptive quality =====
+
+static gboolean quality_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data) {
+    gint64 counter = gdk_frame_clock_get_frame_counter(frame_clock);
+    gint64 frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+    
+    // Several animations can share a frame clock, sample each frame once
+    if (frame_clock == quality.clock && counter == quality.frame_counter) {
+        return G_SOURCE_CONTINUE;
+    }
+    
+    gboolean consecutive = frame_clock == quality.clock && counter == quality.frame_counter + 1;
+    gint64 interval = frame_time - quality.frame_time;
+    quality.clock = frame_clock;
+    quality.frame_counter = counter;
+    quality.frame_time = frame_time;
+    
+    if (!consecutive || interval <= 0) {
+        return G_SOURCE_CONTINUE;
+    }
+    if (interval > QUALITY_IDLE_GAP_US) {
+        // The clock idled, earlier slowness says nothing about what comes next
+        quality_reset("frame clock was idle");
+        return G_SOURCE_CONTINUE;
+    }
+    
+    gint64 budget = 0, presentation_time = 0;
+    gdk_frame_clock_get_refresh_info(frame_clock, frame_time, &budget, &presentation_time);
+    if (budget <= 0) {
+        budget = QUALITY_DEFAULT_REFRESH_US;
+    }
+    
+    if (quality.avg_interval_us <= 0) {
+        quality.avg_interval_us = interval;
+    } else {
+        quality.avg_interval_us += QUALITY_EWMA_WEIGHT * (interval - quality.avg_interval_us);
+    }
+    
+    if (quality.avg_interval_us > budget * QUALITY_SLOW_FACTOR) {
+        quality.slow_frames++;
+        quality.fast_frames = 0;
+    } else if (quality.avg_interval_us < budget * QUALITY_FAST_FACTOR) {
+        quality.fast_frames++;
+        quality.slow_frames = 0;
+    } else {
+        quality.slow_frames = 0;
+        quality.fast_frames = 0;
+    }
+    
+    // Dwell time keeps the policy from flapping between levels
+    if (frame_time - quality.level_since < QUALITY_MIN_DWELL_US) {
+        return G_SOURCE_CONTINUE;
+    }
+    
+    AnimationQuality level = quality.level;
+    if (quality.slow_frames >= QUALITY_DEGRADE_FRAMES && level < ANIMATION_QUALITY_MINIMAL) {
+        level++;
+    } else if (quality.fast_frames >= QUALITY_RECOVER_FRAMES && level > ANIMATION_QUALITY_FULL) {
+        level--;
+    }
+    
+    if (level != quality.level) {
+        char *reason = g_strdup_printf("average frame %.1f ms against a %.1f ms budget",
+                                       quality.avg_interval_us / 1000.0, budget / 1000.0);
+        quality_set_level(level, reason);
+        g_free(reason);
+    }
+    
+    return G_SOURCE_CONTINUE;
+}
+
+static void quality_set_level(AnimationQuality level, const char *reason) {
+    AnimationQuality old_level = quality.level;
+    
+    quality.level = level;
+    quality.level_since = quality.frame_time;
+    quality.slow_frames = 0;
+    quality.fast_frames = 0;
+    
+    if (quality.log_func) {
+        quality.log_func(old_level, level, reason, quality.log_data);
+    } else {
+        g_print("Animation quality %s -> %s (%s)\n",
+                animation_quality_to_string(old_level),
+                animation_quality_to_string(level), reason);
+    }
+}
+
+// Start the next animation from full quality with a fresh average rather
+// than climbing back up from a level reached during an earlier hiccup
+static void quality_reset(const char *reason) {
+    quality.avg_interval_us = 0;
+    quality.slow_frames = 0;
+    quality.fast_frames = 0;
+    
+    if (quality.level != ANIMATION_QUALITY_FULL) {
+        quality_set_level(ANIMATION_QUALITY_FULL, reason);
+    }
+}
+
+// At minimal quality transforms are restyled on every other tick only
+static gboolean quality_throttled(guint *tick_count) {
+    if (quality.level < ANIMATION_QUALITY_MINIMAL) {
+        return FALSE;
+    }
+    return (++(*tick_count) % 2) != 0;
+}
+
+static void start_tracking(GtkWidget *widget, guint *tick_id) {
+    *tick_id = gtk_widget_add_tick_callback(widget, quality_tick, NULL, NULL);
+    quality.trackers++;
+}
+
+static void stop_tracking(GtkWidget *widget, guint *tick_id) {
+    if (*tick_id > 0) {
+        gtk_widget_remove_tick_callback(widget, *tick_id);
+        *tick_id = 0;
+        
+        if (--quality.trackers == 0) {
+            quality_reset("no animations running");
+        }
+    }
+}
+
+AnimationQuality animation_get_quality(void) {
+    return quality.level;
+}
+
+const char *animation_quality_to_string(AnimationQuality level) {
+    switch (level) {
+        case ANIMATION_QUALITY_FULL:
+            return "full";
+        case ANIMATION_QUALITY_REDUCED:
+            return "reduced";
+        case ANIMATION_QUALITY_MINIMAL:
+            return "minimal";
+        default:
+            return "unknown";
+    }
+}
+
+void animation_set_policy_log(AnimationPolicyLogFunc func, gpointer user_data) {
+    quality.log_func = func;
+    quality.log_data = user_data;
+}
@@ -11,6 +11,27 @@ typedef struct {
     guint duration_ms;
 } AnimationParams;
 
+// Adaptive quality: animations watch real frame times and shed work when
+// they keep missing the frame budget, then recover once frames are fast
+// again. Quality returns to full when the last animation stops or the frame
+// clock idles, so a past hiccup never degrades the next animation.
+typedef enum {
+    ANIMATION_QUALITY_FULL,
+    ANIMATION_QUALITY_REDUCED,  // non-essential effects (pulse) are paused
+    ANIMATION_QUALITY_MINIMAL   // transforms are restyled every other tick
+} AnimationQuality;
+
+typedef enum {
+    ANIMATION_KIND_PULSE,
+    ANIMATION_KIND_ROTATION,
+    ANIMATION_KIND_CAMERA
+} AnimationKind;
+
+typedef void (*AnimationPolicyLogFunc)(AnimationQuality old_quality,
+                                       AnimationQuality new_quality,
+                                       const char *reason,
+                                       gpointer user_data);
+
 // Basic animation function
 void animate_property(AnimationParams *params, const char *property);
 
@@ -24,4 +45,13 @@ void move_and_rotate(GtkWidget *widget, GtkWidget *slides,
                     gint y_position, gdouble rotation, 
                     guint move_duration, guint rotate_duration);
 
+// Stops the widget's animation of that kind, if any, where it currently is
+void animation_cancel(GtkWidget *widget, AnimationKind kind);
+
+// Quality policy
+AnimationQuality animation_get_quality(void);
+const char *animation_quality_to_string(AnimationQuality quality);
+// Every quality decision is passed here; the default prints it
+void animation_set_policy_log(AnimationPolicyLogFunc func, gpointer user_data);
+
 #endif
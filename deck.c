@@ -0,0 +1,291 @@
+#include "deck.h"
+#include "memory_budget.h"
+
+#define MEDIA_CACHE_BUDGET (256 * 1024 * 1024)
+
+// Decoded media across all decks, least recently used first. Lock order is
+// media_cache_lock before DeckMedia.lock.
+static GMutex media_cache_lock;
+static GQueue media_cache = G_QUEUE_INIT;
+static MemoryAccount *media_account;
+
+// Static helper functions
+static DeckMedia *deck_media_new(const char *path, ZipReader *archive);
+static void deck_media_free(DeckMedia *media);
+static MemoryAccount *get_media_account(void);
+static void evict_media(MemoryAccount *account, gsize target_bytes, gpointer user_data);
+static void find_files(const char *dir, const char *relative_dir,
+                       const char * const *suffixes, GPtrArray *files);
+
+Slide *slide_new(guint index) {
+    Slide *slide = g_new0(Slide, 1);
+    slide->index = index;
+    slide->paragraphs = g_ptr_array_new_with_free_func(g_free);
+    slide->media = g_ptr_array_new_with_free_func(g_free);
+    return slide;
+}
+
+void slide_free(Slide *slide) {
+    if (slide) {
+        g_free(slide->title);
+        g_ptr_array_unref(slide->paragraphs);
+        g_ptr_array_unref(slide->media);
+        g_free(slide);
+    }
+}
+
+static DeckMedia *deck_media_new(const char *path, ZipReader *archive) {
+    DeckMedia *media = g_new0(DeckMedia, 1);
+    media->path = g_strdup(path);
+    media->archive = archive ? zip_reader_ref(archive) : NULL;
+    g_mutex_init(&media->lock);
+    return media;
+}
+
+static void deck_media_free(DeckMedia *media) {
+    if (media) {
+        g_mutex_lock(&media_cache_lock);
+        if (media->cache_link) {
+            g_queue_delete_link(&media_cache, media->cache_link);
+            media->cache_link = NULL;
+            memory_account_add(media_account, -(gssize)media->texture_bytes);
+        }
+        g_mutex_unlock(&media_cache_lock);
+
+        g_clear_object(&media->texture);
+        if (media->archive) {
+            zip_reader_unref(media->archive);
+        }
+        g_mutex_clear(&media->lock);
+        g_free(media->path);
+        g_free(media);
+    }
+}
+
+Deck *deck_new(const char *source_path, ZipReader *archive) {
+    Deck *deck = g_new0(Deck, 1);
+    deck->source_path = g_strdup(source_path);
+    deck->slides = g_ptr_array_new_with_free_func((GDestroyNotify)slide_free);
+    deck->media = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                        (GDestroyNotify)deck_media_free);
+    deck->archive = archive ? zip_reader_ref(archive) : NULL;
+    return deck;
+}
+
+void deck_free(Deck *deck) {
+    if (deck) {
+        g_ptr_array_unref(deck->slides);
+        g_hash_table_destroy(deck->media);
+        if (deck->archive) {
+            zip_reader_unref(deck->archive);
+        }
+        g_free(deck->source_path);
+        g_free(deck);
+    }
+}
+
+void deck_collect_media(Deck *deck) {
+    for (guint i = 0; i < deck->slides->len; i++) {
+        Slide *slide = g_ptr_array_index(deck->slides, i);
+        for (guint j = 0; j < slide->media->len; j++) {
+            const char *path = g_ptr_array_index(slide->media, j);
+            if (!g_hash_table_contains(deck->media, path)) {
+                DeckMedia *media = deck_media_new(path, deck->archive);
+                g_hash_table_insert(deck->media, media->path, media);
+            }
+        }
+    }
+}
+
+DeckMedia *deck_get_media(Deck *deck, const char *path) {
+    return g_hash_table_lookup(deck->media, path);
+}
+
+static MemoryAccount *get_media_account(void) {
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        media_account = memory_account_register("media", MEDIA_CACHE_BUDGET, evict_media, NULL);
+        g_once_init_leave(&initialized, 1);
+    }
+    return media_account;
+}
+
+static void evict_media(MemoryAccount *account, gsize target_bytes, gpointer user_data) {
+    g_mutex_lock(&media_cache_lock);
+    while (memory_account_get_usage(account) > target_bytes && media_cache.head) {
+        DeckMedia *media = g_queue_pop_head(&media_cache);
+        media->cache_link = NULL;
+
+        // Still in the archive, the next request simply decodes it again
+        g_mutex_lock(&media->lock);
+        memory_account_add(account, -(gssize)media->texture_bytes);
+        media->texture_bytes = 0;
+        g_clear_object(&media->texture);
+        g_mutex_unlock(&media->lock);
+    }
+    g_mutex_unlock(&media_cache_lock);
+}
+
+GdkTexture *deck_media_get_texture(DeckMedia *media, GError **error) {
+    MemoryAccount *account = get_media_account();
+    GdkTexture *texture = NULL;
+    gsize decoded_bytes = 0;
+
+    g_mutex_lock(&media->lock);
+    if (!media->texture && media->archive) {
+        GBytes *bytes = zip_reader_read_by_name(media->archive, media->path, error);
+        if (bytes) {
+            media->texture = gdk_texture_new_from_bytes(bytes, error);
+            g_bytes_unref(bytes);
+        }
+        if (media->texture) {
+            media->texture_bytes = (gsize)gdk_texture_get_width(media->texture) *
+                                   gdk_texture_get_height(media->texture) * 4;
+            decoded_bytes = media->texture_bytes;
+        }
+    }
+    if (media->texture) {
+        texture = g_object_ref(media->texture);
+    }
+    g_mutex_unlock(&media->lock);
+
+    if (texture) {
+        // Charge before the media becomes evictable, so eviction never
+        // uncharges bytes that were not added yet. No lock is held here
+        // because in headless mode this may run the eviction itself.
+        if (decoded_bytes > 0) {
+            memory_account_add(account, decoded_bytes);
+        }
+
+        g_mutex_lock(&media_cache_lock);
+        if (decoded_bytes > 0) {
+            g_queue_push_tail(&media_cache, media);
+            media->cache_link = media_cache.tail;
+        } else if (media->cache_link) {
+            g_queue_unlink(&media_cache, media->cache_link);
+            g_queue_push_tail_link(&media_cache, media->cache_link);
+        }
+        g_mutex_unlock(&media_cache_lock);
+    }
+
+    return texture;
+}
+
+gboolean deck_save(Deck *deck, const char *path, GError **error) {
+    GKeyFile *key_file = g_key_file_new();
+
+    g_key_file_set_string(key_file, "deck", "source", deck->source_path);
+    g_key_file_set_integer(key_file, "deck", "slides", deck->slides->len);
+
+    for (guint i = 0; i < deck->slides->len; i++) {
+        Slide *slide = g_ptr_array_index(deck->slides, i);
+        char *group = g_strdup_printf("slide %u", i + 1);
+
+        g_key_file_set_string(key_file, group, "title", slide->title ? slide->title : "");
+        g_key_file_set_string_list(key_file, group, "text",
+                                   (const char * const *)slide->paragraphs->pdata,
+                                   slide->paragraphs->len);
+        if (slide->media->len > 0) {
+            g_key_file_set_string_list(key_file, group, "media",
+                                       (const char * const *)slide->media->pdata,
+                                       slide->media->len);
+        }
+        g_free(group);
+    }
+
+    gboolean ok = g_key_file_save_to_file(key_file, path, error);
+    g_key_file_free(key_file);
+
+    return ok;
+}
+
+Deck *deck_load(const char *path, GError **error) {
+    GKeyFile *key_file = g_key_file_new();
+
+    if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, error)) {
+        g_key_file_free(key_file);
+        return NULL;
+    }
+
+    Deck *deck = deck_new(path, NULL);
+    gint count = g_key_file_get_integer(key_file, "deck", "slides", NULL);
+
+    for (gint i = 0; i < count; i++) {
+        char *group = g_strdup_printf("slide %d", i + 1);
+        Slide *slide = slide_new(i);
+        gsize len = 0;
+
+        slide->title = g_key_file_get_string(key_file, group, "title", NULL);
+        if (slide->title && !*slide->title) {
+            g_clear_pointer(&slide->title, g_free);
+        }
+
+        char **text = g_key_file_get_string_list(key_file, group, "text", &len, NULL);
+        for (gsize j = 0; text && j < len; j++) {
+            g_ptr_array_add(slide->paragraphs, text[j]);
+        }
+        g_free(text);
+
+        len = 0;
+        char **media = g_key_file_get_string_list(key_file, group, "media", &len, NULL);
+        for (gsize j = 0; media && j < len; j++) {
+            g_ptr_array_add(slide->media, media[j]);
+        }
+        g_free(media);
+
+        g_ptr_array_add(deck->slides, slide);
+        g_free(group);
+    }
+
+    // Media paths are kept, but there is no archive to decode them from
+    deck_collect_media(deck);
+    g_key_file_free(key_file);
+
+    return deck;
+}
+
+static void find_files(const char *dir, const char *relative_dir,
+                       const char * const *suffixes, GPtrArray *files) {
+    char *dir_path = g_build_filename(dir, relative_dir, NULL);
+    GDir *gdir = g_dir_open(dir_path, 0, NULL);
+    const char *name;
+
+    if (!gdir) {
+        g_free(dir_path);
+        return;
+    }
+
+    while ((name = g_dir_read_name(gdir))) {
+        char *path = g_build_filename(dir_path, name, NULL);
+        char *relative = g_build_filename(relative_dir, name, NULL);
+
+        if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+            find_files(dir, relative, suffixes, files);
+            g_free(relative);
+        } else {
+            char *lower = g_ascii_strdown(name, -1);
+            gboolean match = FALSE;
+            for (guint i = 0; suffixes[i] && !match; i++) {
+                match = g_str_has_suffix(lower, suffixes[i]);
+            }
+            if (match) {
+                g_ptr_array_add(files, relative);
+            } else {
+                g_free(relative);
+            }
+            g_free(lower);
+        }
+
+        g_free(path);
+    }
+
+    g_dir_close(gdir);
+    g_free(dir_path);
+}
+
+GPtrArray *deck_find_files(const char *dir, const char * const *suffixes) {
+    GPtrArray *files = g_ptr_array_new_with_free_func(g_free);
+    find_files(dir, "", suffixes, files);
+    return files;
+}
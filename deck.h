@@ -0,0 +1,58 @@
+#ifndef DECK_H
+#define DECK_H
+
+#include <gtk/gtk.h>
+#include "zip_reader.h"
+
+// In-memory document model for a presentation
+
+// An image referenced by one or more slides. It stays compressed inside the
+// source archive until a texture is actually requested.
+typedef struct {
+    char *path;
+    ZipReader *archive;
+    GMutex lock;
+    GdkTexture *texture;
+    gsize texture_bytes;
+    GList *cache_link; // In the shared LRU while decoded
+} DeckMedia;
+
+typedef struct {
+    guint index;
+    char *title;
+    GPtrArray *paragraphs; // char*
+    GPtrArray *media;      // char* archive paths, see deck_get_media()
+} Slide;
+
+typedef struct {
+    char *source_path;
+    GPtrArray *slides;     // Slide*
+    GHashTable *media;     // path -> DeckMedia*
+    ZipReader *archive;
+} Deck;
+
+Slide *slide_new(guint index);
+void slide_free(Slide *slide);
+
+Deck *deck_new(const char *source_path, ZipReader *archive);
+void deck_free(Deck *deck);
+
+// Registers every media path used by the slides, without decoding anything
+void deck_collect_media(Deck *deck);
+DeckMedia *deck_get_media(Deck *deck, const char *path);
+
+// Decodes on first use, safe to call from any thread. Decoded textures are
+// charged to the "media" memory account and may be evicted again, least
+// recently used first.
+GdkTexture *deck_media_get_texture(DeckMedia *media, GError **error);
+
+// Native format, a GKeyFile with one group per slide
+gboolean deck_save(Deck *deck, const char *path, GError **error);
+Deck *deck_load(const char *path, GError **error);
+
+// Relative paths of every file below dir whose name ends in one of the
+// NULL-terminated suffixes (case insensitive), subdirectories included.
+// Shared by the batch import and render modes.
+GPtrArray *deck_find_files(const char *dir, const char * const *suffixes);
+
+#endif
@@ -0,0 +1,625 @@
+#include "import.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define PPTX_PRESENTATION_PART "ppt/presentation.xml"
+#define ODP_CONTENT_PART "content.xml"
+
+typedef struct {
+    GHashTable *targets; // relationship id -> resolved part path
+    const char *base_dir;
+} RelsParser;
+
+typedef struct {
+    GPtrArray *slide_ids; // relationship ids in presentation order
+} PresentationParser;
+
+typedef struct {
+    Slide *slide;
+    GString *paragraph;
+    gboolean in_paragraph;
+    gboolean in_text;
+    gboolean in_title_shape;
+    GPtrArray *embeds; // relationship ids of images
+} PptxSlideParser;
+
+typedef struct {
+    Deck *deck;
+    Slide *slide;
+    GString *paragraph;
+    gint text_depth;
+    gint notes_depth;
+    gboolean in_title_frame;
+} OdpParser;
+
+// Completion tracking for one deck's slide parts on the shared pool
+typedef struct {
+    GMutex lock;
+    GCond done;
+    guint pending;
+} SlideBatch;
+
+typedef struct {
+    ZipReader *archive;
+    char *part;
+    guint index;
+    Slide *slide;
+    GError *error;
+    SlideBatch *batch;
+} PptxSlideJob;
+
+typedef struct {
+    char *input_path;
+    char *output_path;
+} BatchJob;
+
+typedef struct {
+    gint converted;
+    gint failed;
+} BatchState;
+
+// Static helper functions
+static const char *local_name(const char *name);
+static const char *find_attribute(const char **names, const char **values,
+                                  const char *local, gboolean prefixed);
+static char *resolve_part_path(const char *base_dir, const char *target);
+static gboolean parse_part(ZipReader *archive, const char *part, const GMarkupParser *parser,
+                           gpointer user_data, GError **error);
+static void finish_paragraph(Slide *slide, GString *paragraph, gboolean is_title);
+static GHashTable *load_rels(ZipReader *archive, const char *part);
+static Slide *parse_pptx_slide(ZipReader *archive, const char *part, guint index, GError **error);
+static GThreadPool *get_slide_pool(void);
+static void pptx_slide_worker(gpointer data, gpointer user_data);
+static gboolean import_pptx(Deck *deck, GError **error);
+static gboolean import_odp(Deck *deck, GError **error);
+static void batch_worker(gpointer data, gpointer user_data);
+static void batch_job_free(BatchJob *job);
+
+// ===== XML helpers =====
+
+// Match elements by local name so documents using unusual namespace
+// prefixes still import
+static const char *local_name(const char *name) {
+    const char *colon = strrchr(name, ':');
+    return colon ? colon + 1 : name;
+}
+
+static const char *find_attribute(const char **names, const char **values,
+                                  const char *local, gboolean prefixed) {
+    for (guint i = 0; names[i]; i++) {
+        if (prefixed && !strchr(names[i], ':')) {
+            continue;
+        }
+        if (strcmp(local_name(names[i]), local) == 0) {
+            return values[i];
+        }
+    }
+    return NULL;
+}
+
+static char *resolve_part_path(const char *base_dir, const char *target) {
+    if (target[0] == '/') {
+        return g_strdup(target + 1);
+    }
+
+    char *joined = g_strconcat(base_dir, "/", target, NULL);
+    char **parts = g_strsplit(joined, "/", -1);
+    GPtrArray *stack = g_ptr_array_new();
+
+    for (char **part = parts; *part; part++) {
+        if (**part == '\0' || strcmp(*part, ".") == 0) {
+            continue;
+        }
+        if (strcmp(*part, "..") == 0) {
+            if (stack->len > 0) {
+                g_ptr_array_remove_index(stack, stack->len - 1);
+            }
+            continue;
+        }
+        g_ptr_array_add(stack, *part);
+    }
+    g_ptr_array_add(stack, NULL);
+
+    char *resolved = g_strjoinv("/", (char **)stack->pdata);
+
+    g_ptr_array_free(stack, TRUE);
+    g_strfreev(parts);
+    g_free(joined);
+
+    return resolved;
+}
+
+static gboolean parse_part(ZipReader *archive, const char *part, const GMarkupParser *parser,
+                           gpointer user_data, GError **error) {
+    GBytes *bytes = zip_reader_read_by_name(archive, part, error);
+    if (!bytes) {
+        return FALSE;
+    }
+
+    gsize size;
+    const char *data = g_bytes_get_data(bytes, &size);
+    GMarkupParseContext *context = g_markup_parse_context_new(parser, 0, user_data, NULL);
+
+    gboolean ok = g_markup_parse_context_parse(context, data, size, error) &&
+                  g_markup_parse_context_end_parse(context, error);
+    if (!ok) {
+        g_prefix_error(error, "%s: ", part);
+    }
+
+    g_markup_parse_context_free(context);
+    g_bytes_unref(bytes);
+
+    return ok;
+}
+
+static void finish_paragraph(Slide *slide, GString *paragraph, gboolean is_title) {
+    g_strstrip(paragraph->str);
+    paragraph->len = strlen(paragraph->str);
+
+    if (paragraph->len > 0) {
+        g_ptr_array_add(slide->paragraphs, g_strdup(paragraph->str));
+        if (is_title && !slide->title) {
+            slide->title = g_strdup(paragraph->str);
+        }
+    }
+    g_string_truncate(paragraph, 0);
+}
+
+// ===== PowerPoint =====
+
+static void rels_start_element(GMarkupParseContext *context, const char *element_name,
+                               const char **attribute_names, const char **attribute_values,
+                               gpointer user_data, GError **error) {
+    RelsParser *parser = (RelsParser *)user_data;
+
+    if (strcmp(local_name(element_name), "Relationship") != 0) {
+        return;
+    }
+
+    const char *id = find_attribute(attribute_names, attribute_values, "Id", FALSE);
+    const char *target = find_attribute(attribute_names, attribute_values, "Target", FALSE);
+    const char *mode = find_attribute(attribute_names, attribute_values, "TargetMode", FALSE);
+
+    if (id && target && g_strcmp0(mode, "External") != 0) {
+        g_hash_table_insert(parser->targets, g_strdup(id),
+                            resolve_part_path(parser->base_dir, target));
+    }
+}
+
+static GHashTable *load_rels(ZipReader *archive, const char *part) {
+    // ppt/slides/slide1.xml -> ppt/slides/_rels/slide1.xml.rels
+    char *dir = g_path_get_dirname(part);
+    char *base = g_path_get_basename(part);
+    const char *base_dir = strcmp(dir, ".") == 0 ? "" : dir;
+    char *rels_part = *base_dir ? g_strdup_printf("%s/_rels/%s.rels", base_dir, base)
+                                : g_strdup_printf("_rels/%s.rels", base);
+
+    static const GMarkupParser markup = { rels_start_element, NULL, NULL, NULL, NULL };
+    RelsParser parser = {
+        .targets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+        .base_dir = base_dir,
+    };
+
+    // Parts without relationships are normal, treat errors as "none"
+    if (zip_reader_find(archive, rels_part)) {
+        parse_part(archive, rels_part, &markup, &parser, NULL);
+    }
+
+    g_free(rels_part);
+    g_free(base);
+    g_free(dir);
+
+    return parser.targets;
+}
+
+static void presentation_start_element(GMarkupParseContext *context, const char *element_name,
+                                       const char **attribute_names, const char **attribute_values,
+                                       gpointer user_data, GError **error) {
+    PresentationParser *parser = (PresentationParser *)user_data;
+
+    if (strcmp(local_name(element_name), "sldId") == 0) {
+        // r:id, not the numeric id attribute
+        const char *rel_id = find_attribute(attribute_names, attribute_values, "id", TRUE);
+        if (rel_id) {
+            g_ptr_array_add(parser->slide_ids, g_strdup(rel_id));
+        }
+    }
+}
+
+static void pptx_start_element(GMarkupParseContext *context, const char *element_name,
+                               const char **attribute_names, const char **attribute_values,
+                               gpointer user_data, GError **error) {
+    PptxSlideParser *parser = (PptxSlideParser *)user_data;
+    const char *name = local_name(element_name);
+
+    if (strcmp(name, "sp") == 0) {
+        parser->in_title_shape = FALSE;
+    } else if (strcmp(name, "ph") == 0) {
+        const char *type = find_attribute(attribute_names, attribute_values, "type", FALSE);
+        if (g_strcmp0(type, "title") == 0 || g_strcmp0(type, "ctrTitle") == 0) {
+            parser->in_title_shape = TRUE;
+        }
+    } else if (strcmp(name, "p") == 0) {
+        parser->in_paragraph = TRUE;
+        g_string_truncate(parser->paragraph, 0);
+    } else if (strcmp(name, "t") == 0) {
+        parser->in_text = parser->in_paragraph;
+    } else if (strcmp(name, "br") == 0) {
+        g_string_append_c(parser->paragraph, ' ');
+    } else if (strcmp(name, "blip") == 0) {
+        const char *embed = find_attribute(attribute_names, attribute_values, "embed", TRUE);
+        if (embed) {
+            g_ptr_array_add(parser->embeds, g_strdup(embed));
+        }
+    }
+}
+
+static void pptx_end_element(GMarkupParseContext *context, const char *element_name,
+                             gpointer user_data, GError **error) {
+    PptxSlideParser *parser = (PptxSlideParser *)user_data;
+    const char *name = local_name(element_name);
+
+    if (strcmp(name, "t") == 0) {
+        parser->in_text = FALSE;
+    } else if (strcmp(name, "p") == 0 && parser->in_paragraph) {
+        parser->in_paragraph = FALSE;
+        finish_paragraph(parser->slide, parser->paragraph, parser->in_title_shape);
+    } else if (strcmp(name, "sp") == 0) {
+        parser->in_title_shape = FALSE;
+    }
+}
+
+static void pptx_text(GMarkupParseContext *context, const char *text, gsize text_len,
+                      gpointer user_data, GError **error) {
+    PptxSlideParser *parser = (PptxSlideParser *)user_data;
+
+    if (parser->in_text) {
+        g_string_append_len(parser->paragraph, text, text_len);
+    }
+}
+
+static Slide *parse_pptx_slide(ZipReader *archive, const char *part, guint index, GError **error) {
+    static const GMarkupParser markup = {
+        pptx_start_element, pptx_end_element, pptx_text, NULL, NULL
+    };
+    PptxSlideParser parser = {
+        .slide = slide_new(index),
+        .paragraph = g_string_new(NULL),
+        .embeds = g_ptr_array_new_with_free_func(g_free),
+    };
+
+    if (!parse_part(archive, part, &markup, &parser, error)) {
+        slide_free(parser.slide);
+        parser.slide = NULL;
+    } else if (parser.embeds->len > 0) {
+        // Only resolve image paths here, decoding happens on demand
+        GHashTable *rels = load_rels(archive, part);
+        for (guint i = 0; i < parser.embeds->len; i++) {
+            const char *target = g_hash_table_lookup(rels, g_ptr_array_index(parser.embeds, i));
+            if (target && !g_ptr_array_find_with_equal_func(parser.slide->media, target,
+                                                            g_str_equal, NULL)) {
+                g_ptr_array_add(parser.slide->media, g_strdup(target));
+            }
+        }
+        g_hash_table_destroy(rels);
+    }
+
+    if (parser.slide && !parser.slide->title && parser.slide->paragraphs->len > 0) {
+        parser.slide->title = g_strdup(g_ptr_array_index(parser.slide->paragraphs, 0));
+    }
+
+    g_string_free(parser.paragraph, TRUE);
+    g_ptr_array_unref(parser.embeds);
+
+    return parser.slide;
+}
+
+// One pool for the whole process, shared by every import, so parsing a
+// directory of decks never runs more parser threads than there are cores
+static GThreadPool *get_slide_pool(void) {
+    static GThreadPool *pool = NULL;
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        pool = g_thread_pool_new(pptx_slide_worker, NULL, g_get_num_processors(), FALSE, NULL);
+        g_once_init_leave(&initialized, 1);
+    }
+    return pool;
+}
+
+static void pptx_slide_worker(gpointer data, gpointer user_data) {
+    PptxSlideJob *job = (PptxSlideJob *)data;
+    SlideBatch *batch = job->batch;
+
+    job->slide = parse_pptx_slide(job->archive, job->part, job->index, &job->error);
+
+    if (batch) {
+        g_mutex_lock(&batch->lock);
+        if (--batch->pending == 0) {
+            g_cond_signal(&batch->done);
+        }
+        g_mutex_unlock(&batch->lock);
+    }
+}
+
+static gboolean import_pptx(Deck *deck, GError **error) {
+    static const GMarkupParser markup = { presentation_start_element, NULL, NULL, NULL, NULL };
+    PresentationParser presentation = { .slide_ids = g_ptr_array_new_with_free_func(g_free) };
+
+    if (!parse_part(deck->archive, PPTX_PRESENTATION_PART, &markup, &presentation, error)) {
+        g_ptr_array_unref(presentation.slide_ids);
+        return FALSE;
+    }
+
+    GHashTable *rels = load_rels(deck->archive, PPTX_PRESENTATION_PART);
+    GPtrArray *jobs = g_ptr_array_new();
+
+    for (guint i = 0; i < presentation.slide_ids->len; i++) {
+        const char *part = g_hash_table_lookup(rels, g_ptr_array_index(presentation.slide_ids, i));
+        if (!part) {
+            continue;
+        }
+        PptxSlideJob *job = g_new0(PptxSlideJob, 1);
+        job->archive = deck->archive;
+        job->part = g_strdup(part);
+        job->index = jobs->len;
+        g_ptr_array_add(jobs, job);
+    }
+
+    // Slide parts are independent: inflate and parse them across cores.
+    // Pool workers never wait on anything, so callers that are pool
+    // workers themselves (batch import, render) can't deadlock here.
+    GThreadPool *pool = jobs->len > 1 ? get_slide_pool() : NULL;
+    SlideBatch batch = { .pending = jobs->len };
+    g_mutex_init(&batch.lock);
+    g_cond_init(&batch.done);
+
+    for (guint i = 0; i < jobs->len; i++) {
+        PptxSlideJob *job = g_ptr_array_index(jobs, i);
+        job->batch = &batch;
+        if (!pool || !g_thread_pool_push(pool, job, NULL)) {
+            pptx_slide_worker(job, NULL);
+        }
+    }
+
+    g_mutex_lock(&batch.lock);
+    while (batch.pending > 0) {
+        g_cond_wait(&batch.done, &batch.lock);
+    }
+    g_mutex_unlock(&batch.lock);
+    g_mutex_clear(&batch.lock);
+    g_cond_clear(&batch.done);
+
+    gboolean ok = TRUE;
+    for (guint i = 0; i < jobs->len; i++) {
+        PptxSlideJob *job = g_ptr_array_index(jobs, i);
+        if (job->slide) {
+            g_ptr_array_add(deck->slides, job->slide);
+        } else if (ok) {
+            g_propagate_error(error, job->error);
+            job->error = NULL;
+            ok = FALSE;
+        }
+        g_clear_error(&job->error);
+        g_free(job->part);
+        g_free(job);
+    }
+
+    g_ptr_array_unref(jobs);
+    g_hash_table_destroy(rels);
+    g_ptr_array_unref(presentation.slide_ids);
+
+    return ok;
+}
+
+// ===== OpenDocument =====
+
+static void odp_start_element(GMarkupParseContext *context, const char *element_name,
+                              const char **attribute_names, const char **attribute_values,
+                              gpointer user_data, GError **error) {
+    OdpParser *parser = (OdpParser *)user_data;
+    const char *name = local_name(element_name);
+
+    if (strcmp(name, "page") == 0) {
+        parser->slide = slide_new(parser->deck->slides->len);
+        g_ptr_array_add(parser->deck->slides, parser->slide);
+    } else if (!parser->slide) {
+        return;
+    } else if (strcmp(name, "notes") == 0) {
+        parser->notes_depth++;
+    } else if (parser->notes_depth > 0) {
+        return;
+    } else if (strcmp(name, "frame") == 0) {
+        const char *class = find_attribute(attribute_names, attribute_values, "class", TRUE);
+        parser->in_title_frame = g_strcmp0(class, "title") == 0;
+    } else if (strcmp(name, "p") == 0 || strcmp(name, "h") == 0) {
+        if (parser->text_depth++ == 0) {
+            g_string_truncate(parser->paragraph, 0);
+        }
+    } else if (strcmp(name, "s") == 0 || strcmp(name, "tab") == 0 ||
+               strcmp(name, "line-break") == 0) {
+        g_string_append_c(parser->paragraph, ' ');
+    } else if (strcmp(name, "image") == 0) {
+        const char *href = find_attribute(attribute_names, attribute_values, "href", TRUE);
+        if (href && !strstr(href, "://")) {
+            char *path = resolve_part_path("", href);
+            if (!g_ptr_array_find_with_equal_func(parser->slide->media, path, g_str_equal, NULL)) {
+                g_ptr_array_add(parser->slide->media, path);
+            } else {
+                g_free(path);
+            }
+        }
+    }
+}
+
+static void odp_end_element(GMarkupParseContext *context, const char *element_name,
+                            gpointer user_data, GError **error) {
+    OdpParser *parser = (OdpParser *)user_data;
+    const char *name = local_name(element_name);
+
+    if (!parser->slide) {
+        return;
+    }
+
+    if (strcmp(name, "page") == 0) {
+        if (!parser->slide->title && parser->slide->paragraphs->len > 0) {
+            parser->slide->title = g_strdup(g_ptr_array_index(parser->slide->paragraphs, 0));
+        }
+        parser->slide = NULL;
+    } else if (strcmp(name, "notes") == 0) {
+        parser->notes_depth--;
+    } else if (parser->notes_depth > 0) {
+        return;
+    } else if (strcmp(name, "frame") == 0) {
+        parser->in_title_frame = FALSE;
+    } else if ((strcmp(name, "p") == 0 || strcmp(name, "h") == 0) && parser->text_depth > 0) {
+        if (--parser->text_depth == 0) {
+            finish_paragraph(parser->slide, parser->paragraph, parser->in_title_frame);
+        }
+    }
+}
+
+static void odp_text(GMarkupParseContext *context, const char *text, gsize text_len,
+                     gpointer user_data, GError **error) {
+    OdpParser *parser = (OdpParser *)user_data;
+
+    if (parser->slide && parser->notes_depth == 0 && parser->text_depth > 0) {
+        g_string_append_len(parser->paragraph, text, text_len);
+    }
+}
+
+static gboolean import_odp(Deck *deck, GError **error) {
+    // All pages live in one content part, parsed in a single pass
+    static const GMarkupParser markup = { odp_start_element, odp_end_element, odp_text, NULL, NULL };
+    OdpParser parser = {
+        .deck = deck,
+        .paragraph = g_string_new(NULL),
+    };
+
+    gboolean ok = parse_part(deck->archive, ODP_CONTENT_PART, &markup, &parser, error);
+    g_string_free(parser.paragraph, TRUE);
+
+    return ok;
+}
+
+// ===== Entry points =====
+
+Deck *import_deck(const char *path, GError **error) {
+    ZipReader *archive = zip_reader_open(path, error);
+    if (!archive) {
+        return NULL;
+    }
+
+    Deck *deck = deck_new(path, archive);
+    gboolean ok;
+
+    if (zip_reader_find(archive, PPTX_PRESENTATION_PART)) {
+        ok = import_pptx(deck, error);
+    } else if (zip_reader_find(archive, ODP_CONTENT_PART)) {
+        ok = import_odp(deck, error);
+    } else {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                    "%s: not a PowerPoint or OpenDocument presentation", path);
+        ok = FALSE;
+    }
+
+    zip_reader_unref(archive);
+
+    if (!ok) {
+        deck_free(deck);
+        return NULL;
+    }
+
+    deck_collect_media(deck);
+    return deck;
+}
+
+static void batch_job_free(BatchJob *job) {
+    if (job) {
+        g_free(job->input_path);
+        g_free(job->output_path);
+        g_free(job);
+    }
+}
+
+static void batch_worker(gpointer data, gpointer user_data) {
+    BatchJob *job = (BatchJob *)data;
+    BatchState *state = (BatchState *)user_data;
+    GError *error = NULL;
+
+    Deck *deck = import_deck(job->input_path, &error);
+    if (deck) {
+        char *dir = g_path_get_dirname(job->output_path);
+        g_mkdir_with_parents(dir, 0755);
+        g_free(dir);
+
+        if (!deck_save(deck, job->output_path, &error)) {
+            deck_free(deck);
+            deck = NULL;
+        }
+    }
+
+    if (deck) {
+        g_atomic_int_inc(&state->converted);
+        deck_free(deck);
+    } else {
+        g_printerr("Failed to import %s: %s\n", job->input_path, error->message);
+        g_error_free(error);
+        g_atomic_int_inc(&state->failed);
+    }
+
+    batch_job_free(job);
+}
+
+int import_batch(const char *input_dir, const char *output_dir, guint n_jobs) {
+    static const char * const suffixes[] = { ".pptx", ".odp", NULL };
+    GPtrArray *files = deck_find_files(input_dir, suffixes);
+    GPtrArray *jobs = g_ptr_array_new();
+    BatchState state = {0};
+    GError *error = NULL;
+
+    for (guint i = 0; i < files->len; i++) {
+        const char *relative = g_ptr_array_index(files, i);
+        BatchJob *job = g_new0(BatchJob, 1);
+        // Keep the source extension: foo.pptx and foo.odp side by side
+        // must not both write foo.present
+        job->input_path = g_build_filename(input_dir, relative, NULL);
+        job->output_path = g_strdup_printf("%s/%s.present", output_dir, relative);
+        g_ptr_array_add(jobs, job);
+    }
+    g_ptr_array_unref(files);
+    if (jobs->len == 0) {
+        g_printerr("No .pptx or .odp files found in %s\n", input_dir);
+        g_ptr_array_unref(jobs);
+        return 1;
+    }
+
+    if (n_jobs == 0) {
+        n_jobs = g_get_num_processors();
+    }
+    g_print("Importing %u files with %u workers\n", jobs->len, n_jobs);
+
+    gint64 start_time = g_get_monotonic_time();
+    GThreadPool *pool = g_thread_pool_new(batch_worker, &state, n_jobs, TRUE, &error);
+    if (!pool) {
+        g_printerr("Failed to start workers: %s\n", error->message);
+        g_error_free(error);
+        g_ptr_array_set_free_func(jobs, (GDestroyNotify)batch_job_free);
+        g_ptr_array_unref(jobs);
+        return 1;
+    }
+
+    for (guint i = 0; i < jobs->len; i++) {
+        g_thread_pool_push(pool, g_ptr_array_index(jobs, i), NULL);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    double elapsed = (g_get_monotonic_time() - start_time) / (double)G_USEC_PER_SEC;
+    g_print("Imported %d of %u files in %.2f s (%.1f files/sec), %d failed\n",
+            state.converted, jobs->len, elapsed,
+            elapsed > 0 ? state.converted / elapsed : 0.0, state.failed);
+
+    g_ptr_array_unref(jobs);
+
+    return state.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include "deck.h"
+
+// Imports a PowerPoint (.pptx) or OpenDocument (.odp) presentation. The
+// format is detected from the archive contents, not the file name.
+// PowerPoint slide parts are parsed in parallel on one process-wide pool
+// shared by all imports; ODP keeps every page in a single content part.
+// Media stays compressed in the archive until deck_media_get_texture() is
+// called. Safe to call from several threads at once for different files.
+Deck *import_deck(const char *path, GError **error);
+
+// Converts every .pptx/.odp below input_dir into native .present files in
+// output_dir, mirroring the directory layout and keeping the source
+// extension (talk.pptx -> talk.pptx.present). Files are imported in
+// parallel on n_jobs workers. Returns a process exit code.
+int import_batch(const char *input_dir, const char *output_dir, guint n_jobs);
+
+#endif
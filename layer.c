@@ -0,0 +1,225 @@
+#include "layer.h"
+#include "memory_budget.h"
+
+#define LAYER_CACHE_BUDGET (256 * 1024 * 1024)
+
+struct _PresentLayer {
+    GtkWidget parent_instance;
+    GtkWidget *child;
+    guint active_count;
+    GdkTexture *texture;
+    GskRenderNode *content; // Child node the texture was rendered from
+    graphene_rect_t bounds; // Child node bounds the texture covers
+    int width;
+    int height;
+    int scale;
+    gsize texture_bytes;
+    gboolean evicted; // Dropped for memory, draw uncached until the next begin
+};
+
+G_DEFINE_TYPE(PresentLayer, present_layer, GTK_TYPE_WIDGET)
+
+// Layers holding a texture, oldest capture first. Main thread only.
+static GList *cached_layers;
+static MemoryAccount *layer_account;
+
+// Static helper functions
+static GskRenderNode *snapshot_child(PresentLayer *self);
+static GskRenderNode *content_node(GskRenderNode *node);
+static gboolean capture_child(PresentLayer *self, GskRenderNode *node);
+static void drop_texture(PresentLayer *self);
+static void evict_layers(MemoryAccount *account, gsize target_bytes, gpointer user_data);
+
+static void drop_texture(PresentLayer *self) {
+    if (self->texture) {
+        memory_account_add(layer_account, -(gssize)self->texture_bytes);
+        cached_layers = g_list_remove(cached_layers, self);
+        g_clear_object(&self->texture);
+        self->texture_bytes = 0;
+    }
+    g_clear_pointer(&self->content, gsk_render_node_unref);
+}
+
+static void evict_layers(MemoryAccount *account, gsize target_bytes, gpointer user_data) {
+    while (cached_layers && memory_account_get_usage(account) > target_bytes) {
+        PresentLayer *layer = cached_layers->data;
+        drop_texture(layer);
+        layer->evicted = TRUE;
+        gtk_widget_queue_draw(GTK_WIDGET(layer));
+    }
+}
+
+static GskRenderNode *snapshot_child(PresentLayer *self) {
+    GtkSnapshot *child_snapshot = gtk_snapshot_new();
+    gtk_widget_snapshot_child(GTK_WIDGET(self), self->child, child_snapshot);
+    return gtk_snapshot_free_to_node(child_snapshot);
+}
+
+// GTK keeps returning the same node for a child that hasn't queued a
+// redraw, only the transform wrapping it from the allocation is new
+static GskRenderNode *content_node(GskRenderNode *node) {
+    if (gsk_render_node_get_node_type(node) == GSK_TRANSFORM_NODE) {
+        return gsk_transform_node_get_child(node);
+    }
+    return node;
+}
+
+static gboolean capture_child(PresentLayer *self, GskRenderNode *node) {
+    GtkWidget *widget = GTK_WIDGET(self);
+    GtkNative *native = gtk_widget_get_native(widget);
+    GskRenderer *renderer = native ? gtk_native_get_renderer(native) : NULL;
+
+    if (!renderer) {
+        return FALSE;
+    }
+
+    // Rasterise at device scale so the cached layer stays sharp on HiDPI
+    int scale = gtk_widget_get_scale_factor(widget);
+    graphene_rect_t viewport;
+    gsk_render_node_get_bounds(node, &self->bounds);
+    graphene_rect_scale(&self->bounds, scale, scale, &viewport);
+
+    GskTransform *transform = gsk_transform_scale(NULL, scale, scale);
+    GskRenderNode *scaled = gsk_transform_node_new(node, transform);
+    gsk_transform_unref(transform);
+    self->texture = gsk_renderer_render_texture(renderer, scaled, &viewport);
+    self->width = gtk_widget_get_width(widget);
+    self->height = gtk_widget_get_height(widget);
+    self->scale = scale;
+
+    if (self->texture) {
+        self->content = gsk_render_node_ref(content_node(node));
+        self->texture_bytes = (gsize)gdk_texture_get_width(self->texture) *
+                              gdk_texture_get_height(self->texture) * 4;
+        cached_layers = g_list_append(cached_layers, self);
+        memory_account_add(layer_account, self->texture_bytes);
+    }
+
+    gsk_render_node_unref(scaled);
+
+    return self->texture != NULL;
+}
+
+static void present_layer_snapshot(GtkWidget *widget, GtkSnapshot *snapshot) {
+    PresentLayer *self = PRESENT_LAYER(widget);
+
+    if (!self->child) {
+        return;
+    }
+
+    if (self->active_count == 0 || self->evicted) {
+        gtk_widget_snapshot_child(widget, self->child, snapshot);
+        return;
+    }
+
+    GskRenderNode *node = snapshot_child(self);
+    if (!node) {
+        return;
+    }
+
+    if (self->texture &&
+        (content_node(node) != self->content ||
+         self->width != gtk_widget_get_width(widget) ||
+         self->height != gtk_widget_get_height(widget) ||
+         self->scale != gtk_widget_get_scale_factor(widget))) {
+        drop_texture(self);
+    }
+
+    if (self->texture || capture_child(self, node)) {
+        gtk_snapshot_append_texture(snapshot, self->texture, &self->bounds);
+    } else {
+        gtk_snapshot_append_node(snapshot, node);
+    }
+
+    gsk_render_node_unref(node);
+}
+
+static void present_layer_unrealize(GtkWidget *widget) {
+    PresentLayer *self = PRESENT_LAYER(widget);
+
+    // The texture belongs to this surface's renderer
+    drop_texture(self);
+
+    GTK_WIDGET_CLASS(present_layer_parent_class)->unrealize(widget);
+}
+
+static void present_layer_dispose(GObject *object) {
+    PresentLayer *self = PRESENT_LAYER(object);
+
+    g_clear_pointer(&self->child, gtk_widget_unparent);
+    drop_texture(self);
+
+    G_OBJECT_CLASS(present_layer_parent_class)->dispose(object);
+}
+
+static void present_layer_class_init(PresentLayerClass *klass) {
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+    object_class->dispose = present_layer_dispose;
+    widget_class->snapshot = present_layer_snapshot;
+    widget_class->unrealize = present_layer_unrealize;
+
+    gtk_widget_class_set_layout_manager_type(widget_class, GTK_TYPE_BIN_LAYOUT);
+    gtk_widget_class_set_css_name(widget_class, "layer");
+
+    layer_account = memory_account_register("layers", LAYER_CACHE_BUDGET, evict_layers, NULL);
+}
+
+static void present_layer_init(PresentLayer *self) {
+}
+
+GtkWidget *present_layer_new(GtkWidget *child) {
+    PresentLayer *layer = g_object_new(PRESENT_TYPE_LAYER, NULL);
+    present_layer_set_child(layer, child);
+    return GTK_WIDGET(layer);
+}
+
+void present_layer_set_child(PresentLayer *layer, GtkWidget *child) {
+    g_return_if_fail(PRESENT_IS_LAYER(layer));
+
+    g_clear_pointer(&layer->child, gtk_widget_unparent);
+    if (child) {
+        layer->child = child;
+        gtk_widget_set_parent(child, GTK_WIDGET(layer));
+    }
+    present_layer_invalidate(layer);
+}
+
+GtkWidget *present_layer_get_child(PresentLayer *layer) {
+    g_return_val_if_fail(PRESENT_IS_LAYER(layer), NULL);
+    return layer->child;
+}
+
+void present_layer_begin(PresentLayer *layer) {
+    g_return_if_fail(PRESENT_IS_LAYER(layer));
+
+    if (layer->active_count++ == 0) {
+        // Capture fresh content on the next frame
+        layer->evicted = FALSE;
+        present_layer_invalidate(layer);
+    }
+}
+
+void present_layer_end(PresentLayer *layer) {
+    g_return_if_fail(PRESENT_IS_LAYER(layer));
+
+    if (layer->active_count == 0) {
+        return;
+    }
+    if (--layer->active_count == 0) {
+        present_layer_invalidate(layer);
+    }
+}
+
+gboolean present_layer_is_active(PresentLayer *layer) {
+    g_return_val_if_fail(PRESENT_IS_LAYER(layer), FALSE);
+    return layer->active_count > 0;
+}
+
+void present_layer_invalidate(PresentLayer *layer) {
+    g_return_if_fail(PRESENT_IS_LAYER(layer));
+
+    drop_texture(layer);
+    gtk_widget_queue_draw(GTK_WIDGET(layer));
+}
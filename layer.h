@@ -0,0 +1,33 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <gtk/gtk.h>
+
+// A single-child container that can cache its child as a texture.
+//
+// While a layer is active its child is rendered to a texture once and every
+// following frame draws that texture instead of rendering the subtree again.
+// CSS transform and opacity set on the layer itself still apply, so
+// animating those costs one textured quad per frame. The layer still asks
+// the child for its render node each frame, which GTK answers from its own
+// cache unless the child queued a redraw; a different node means the
+// content changed (hover, a label update) and the texture is captured again.
+// The cache is also dropped when the layer's size or scale changes.
+
+#define PRESENT_TYPE_LAYER (present_layer_get_type())
+G_DECLARE_FINAL_TYPE(PresentLayer, present_layer, PRESENT, LAYER, GtkWidget)
+
+GtkWidget *present_layer_new(GtkWidget *child);
+void present_layer_set_child(PresentLayer *layer, GtkWidget *child);
+GtkWidget *present_layer_get_child(PresentLayer *layer);
+
+// Calls nest: the layer caches until every begin has a matching end
+void present_layer_begin(PresentLayer *layer);
+void present_layer_end(PresentLayer *layer);
+gboolean present_layer_is_active(PresentLayer *layer);
+
+// Only needed for changes GTK doesn't redraw the child for, such as
+// content drawn from outside state the child never queues a draw on
+void present_layer_invalidate(PresentLayer *layer);
+
+#endif
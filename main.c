@@ -1,5 +1,9 @@
 #include <gtk/gtk.h>
 #include <adwaita.h>
+#include "sync.h"
+#include "import.h"
+#include "render.h"
+#include "memory_budget.h"
 
 // Structure to hold application data
 typedef struct {
@@ -8,8 +12,113 @@ typedef struct {
     GtkWidget *sidebar;
     GtkWidget *properties_panel;
     GtkWidget *statusbar;
+    GtkWidget *memory_label;
+    char *sync_lead_address;
+    char *sync_follow_address;
+    SyncLeader *sync_leader;
+    SyncFollower *sync_follower;
+    char *import_batch_dir;
+    char *render_input;
+    char *render_format;
+    char *output_dir;
+    gint jobs;
+    gint memory_limit_mb;
+    gboolean memory_debug;
 } AppData;
 
+static void show_slide(AppData *app_data, guint slide) {
+    char *status = g_strdup_printf("Slide %u", slide);
+    gtk_statusbar_pop(GTK_STATUSBAR(app_data->statusbar), 0);
+    gtk_statusbar_push(GTK_STATUSBAR(app_data->statusbar), 0, status);
+    g_free(status);
+}
+
+static void on_thumbnail_clicked(GtkButton *button, gpointer user_data) {
+    AppData *app_data = (AppData *)user_data;
+    guint slide = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(button), "slide_index"));
+    
+    show_slide(app_data, slide);
+    
+    if (app_data->sync_leader) {
+        sync_leader_broadcast(app_data->sync_leader, slide, 0, TRUE);
+    }
+}
+
+static void on_sync_position(guint slide, gint64 timeline_us, gpointer user_data) {
+    show_slide((AppData *)user_data, slide);
+}
+
+static void setup_sync(AppData *app_data) {
+    GError *error = NULL;
+    
+    if (app_data->sync_lead_address) {
+        app_data->sync_leader = sync_leader_new(app_data->sync_lead_address, &error);
+    } else if (app_data->sync_follow_address) {
+        // Followers only receive positions, slide content stays local
+        app_data->sync_follower = sync_follower_new(app_data->sync_follow_address,
+                                                    app_data->slide_view,
+                                                    on_sync_position, app_data, &error);
+    }
+    
+    if (error) {
+        g_warning("Presentation sync disabled: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static gboolean update_memory_status(gpointer user_data) {
+    AppData *app_data = (AppData *)user_data;
+    char *status = memory_budget_format_status();
+    
+    gtk_label_set_text(GTK_LABEL(app_data->memory_label), status);
+    g_free(status);
+    
+    if (app_data->memory_debug) {
+        memory_budget_dump();
+    }
+    
+    return G_SOURCE_CONTINUE;
+}
+
+static int handle_local_options(GApplication *app, GVariantDict *options, gpointer user_data) {
+    AppData *app_data = (AppData *)user_data;
+    
+    if (app_data->memory_limit_mb > 0) {
+        memory_budget_set_limit((gsize)app_data->memory_limit_mb * 1024 * 1024);
+    }
+    
+    // Batch modes run headless and exit without ever creating a window
+    if (app_data->import_batch_dir || app_data->render_input) {
+        memory_budget_set_headless(TRUE);
+    }
+    
+    if (app_data->import_batch_dir) {
+        return import_batch(app_data->import_batch_dir,
+                            app_data->output_dir ? app_data->output_dir : app_data->import_batch_dir,
+                            MAX(app_data->jobs, 0));
+    }
+    
+    if (app_data->render_input) {
+        RenderFormat format = RENDER_FORMAT_PNG;
+        if (g_strcmp0(app_data->render_format, "pdf") == 0) {
+            format = RENDER_FORMAT_PDF;
+        } else if (app_data->render_format && g_strcmp0(app_data->render_format, "png") != 0) {
+            g_printerr("Unknown render format '%s' (expected png or pdf)\n", app_data->render_format);
+            return 1;
+        }
+        return render_batch(app_data->render_input,
+                            app_data->output_dir ? app_data->output_dir : ".",
+                            format, MAX(app_data->jobs, 0));
+    }
+    
+    // Stage display, confidence monitor etc. run as separate instances
+    if (app_data->sync_lead_address || app_data->sync_follow_address) {
+        g_application_set_flags(app, g_application_get_flags(app) | G_APPLICATION_NON_UNIQUE);
+    }
+    
+    return -1;
+}
+
 static void setup_main_window(GtkApplication *app, AppData *app_data) {
     // Create the main window
     app_data->window = gtk_application_window_new(app);
@@ -38,6 +147,8 @@ static void setup_main_window(GtkApplication *app, AppData *app_data) {
         GtkWidget *thumbnail = gtk_button_new();
         gtk_widget_set_size_request(thumbnail, -1, 60);
         gtk_widget_add_css_class(thumbnail, "slide-thumbnail");
+        g_object_set_data(G_OBJECT(thumbnail), "slide_index", GUINT_TO_POINTER(i));
+        g_signal_connect(thumbnail, "clicked", G_CALLBACK(on_thumbnail_clicked), app_data);
         
         GtkWidget *label = gtk_label_new(g_strdup_printf("Slide %d", i));
         gtk_button_set_child(GTK_BUTTON(thumbnail), label);
@@ -107,15 +218,30 @@ static void setup_main_window(GtkApplication *app, AppData *app_data) {
     gtk_widget_set_margin_top(bg_color_btn, 5);
     gtk_box_append(GTK_BOX(app_data->properties_panel), bg_color_btn);
     
-    // Create status bar
+    // Create status bar, with live cache memory usage on the right
+    GtkWidget *status_row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_box_append(GTK_BOX(content_box), status_row);
+    
     app_data->statusbar = gtk_statusbar_new();
+    gtk_widget_set_hexpand(app_data->statusbar, TRUE);
     gtk_statusbar_push(GTK_STATUSBAR(app_data->statusbar), 0, "Ready");
-    gtk_box_append(GTK_BOX(content_box), app_data->statusbar);
+    gtk_box_append(GTK_BOX(status_row), app_data->statusbar);
+    
+    app_data->memory_label = gtk_label_new(NULL);
+    gtk_widget_set_margin_end(app_data->memory_label, 10);
+    gtk_widget_add_css_class(app_data->memory_label, "dim-label");
+    gtk_box_append(GTK_BOX(status_row), app_data->memory_label);
 }
 
 static void activate(GtkApplication *app, gpointer user_data) {
     AppData *app_data = (AppData *)user_data;
     setup_main_window(app, app_data);
+    setup_sync(app_data);
+    
+    memory_budget_watch_pressure();
+    update_memory_status(app_data);
+    g_timeout_add_seconds(2, update_memory_status, app_data);
+    
     gtk_application_add_window(app, GTK_WINDOW(app_data->window));
     gtk_widget_show(app_data->window);
 }
@@ -126,8 +252,41 @@ int main(int argc, char **argv) {
     AdwApplication *app = adw_application_new("com.example.Present", G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), &app_data);
     
+    GOptionEntry entries[] = {
+        { "sync-lead", 0, 0, G_OPTION_ARG_STRING, &app_data.sync_lead_address,
+          "Broadcast slide position to followers", "unix:PATH|PORT" },
+        { "sync-follow", 0, 0, G_OPTION_ARG_STRING, &app_data.sync_follow_address,
+          "Follow the slide position of a leader", "unix:PATH|PORT" },
+        { "import-batch", 0, 0, G_OPTION_ARG_FILENAME, &app_data.import_batch_dir,
+          "Convert every .pptx/.odp in a directory and exit", "DIR" },
+        { "render", 0, 0, G_OPTION_ARG_FILENAME, &app_data.render_input,
+          "Render a deck, or a directory of decks, offscreen and exit", "PATH" },
+        { "format", 0, 0, G_OPTION_ARG_STRING, &app_data.render_format,
+          "Render output format", "png|pdf" },
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &app_data.output_dir,
+          "Output directory for batch modes", "DIR" },
+        { "memory-limit", 0, 0, G_OPTION_ARG_INT, &app_data.memory_limit_mb,
+          "Total cache memory budget in MB (default: 512)", "MB" },
+        { "memory-debug", 0, 0, G_OPTION_ARG_NONE, &app_data.memory_debug,
+          "Periodically print per-cache memory usage", NULL },
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &app_data.jobs,
+          "Number of worker threads (default: all cores)", "N" },
+        { NULL }
+    };
+    g_application_add_main_option_entries(G_APPLICATION(app), entries);
+    g_signal_connect(app, "handle-local-options", G_CALLBACK(handle_local_options), &app_data);
+    
     int status = g_application_run(G_APPLICATION(app), argc, argv);
     g_object_unref(app);
     
+    sync_leader_free(app_data.sync_leader);
+    sync_follower_free(app_data.sync_follower);
+    g_free(app_data.sync_lead_address);
+    g_free(app_data.sync_follow_address);
+    g_free(app_data.import_batch_dir);
+    g_free(app_data.render_input);
+    g_free(app_data.render_format);
+    g_free(app_data.output_dir);
+    
     return status;
 }
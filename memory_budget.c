@@ -0,0 +1,246 @@
+#include "memory_budget.h"
+
+#define MEMORY_BUDGET_DEFAULT_LIMIT (512 * 1024 * 1024)
+
+struct _MemoryAccount {
+    char *name;
+    gsize budget;
+    gsize usage; // atomic
+    MemoryEvictFunc evict;
+    gpointer user_data;
+};
+
+static GMutex accounts_lock;
+static GPtrArray *accounts;
+static gsize global_limit = MEMORY_BUDGET_DEFAULT_LIMIT;
+static gsize total_usage; // atomic
+static gint enforce_pending;
+static gboolean headless;
+static GMemoryMonitor *memory_monitor;
+
+// Static helper functions
+static void schedule_enforce(void);
+static gboolean enforce_idle(gpointer user_data);
+static gint compare_usage_desc(gconstpointer a, gconstpointer b);
+static void evict_account(MemoryAccount *account, gsize target);
+static void on_low_memory_warning(GMemoryMonitor *monitor, GMemoryMonitorWarningLevel level,
+                                  gpointer user_data);
+
+MemoryAccount *memory_account_register(const char *name, gsize budget_bytes,
+                                       MemoryEvictFunc evict, gpointer user_data) {
+    MemoryAccount *account = g_new0(MemoryAccount, 1);
+    account->name = g_strdup(name);
+    account->budget = budget_bytes;
+    account->evict = evict;
+    account->user_data = user_data;
+
+    g_mutex_lock(&accounts_lock);
+    if (!accounts) {
+        accounts = g_ptr_array_new();
+    }
+    g_ptr_array_add(accounts, account);
+    g_mutex_unlock(&accounts_lock);
+
+    return account;
+}
+
+void memory_account_unregister(MemoryAccount *account) {
+    if (account) {
+        g_mutex_lock(&accounts_lock);
+        g_ptr_array_remove(accounts, account);
+        g_mutex_unlock(&accounts_lock);
+
+        g_atomic_pointer_add(&total_usage, -(gssize)g_atomic_pointer_get(&account->usage));
+        g_free(account->name);
+        g_free(account);
+    }
+}
+
+void memory_account_add(MemoryAccount *account, gssize delta_bytes) {
+    if (!account || delta_bytes == 0) {
+        return;
+    }
+
+    gsize usage = (gsize)(g_atomic_pointer_add(&account->usage, delta_bytes) + delta_bytes);
+    gsize total = (gsize)(g_atomic_pointer_add(&total_usage, delta_bytes) + delta_bytes);
+
+    if (delta_bytes > 0 && (usage > account->budget || total > global_limit)) {
+        schedule_enforce();
+    }
+}
+
+gsize memory_account_get_usage(MemoryAccount *account) {
+    return (gsize)g_atomic_pointer_get(&account->usage);
+}
+
+void memory_budget_set_limit(gsize limit_bytes) {
+    global_limit = limit_bytes;
+    schedule_enforce();
+}
+
+void memory_budget_set_headless(gboolean is_headless) {
+    headless = is_headless;
+}
+
+gsize memory_budget_get_limit(void) {
+    return global_limit;
+}
+
+gsize memory_budget_get_usage(void) {
+    return (gsize)g_atomic_pointer_get(&total_usage);
+}
+
+static void schedule_enforce(void) {
+    // Batch modes never iterate a main loop, so an idle would never run
+    if (headless) {
+        memory_budget_enforce();
+        return;
+    }
+
+    // Caches grow on worker threads too; evictions always run on the main
+    // thread, coalesced into a single idle
+    if (g_atomic_int_compare_and_exchange(&enforce_pending, FALSE, TRUE)) {
+        g_idle_add(enforce_idle, NULL);
+    }
+}
+
+static gboolean enforce_idle(gpointer user_data) {
+    g_atomic_int_set(&enforce_pending, FALSE);
+    memory_budget_enforce();
+    return G_SOURCE_REMOVE;
+}
+
+static gint compare_usage_desc(gconstpointer a, gconstpointer b) {
+    gsize x = memory_account_get_usage(*(MemoryAccount **)a);
+    gsize y = memory_account_get_usage(*(MemoryAccount **)b);
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static void evict_account(MemoryAccount *account, gsize target) {
+    gsize before = memory_account_get_usage(account);
+
+    if (before <= target || !account->evict) {
+        return;
+    }
+
+    account->evict(account, target, account->user_data);
+
+    // Caches may have nothing evictable, e.g. every entry still in use
+    gsize after = memory_account_get_usage(account);
+    if (after < before) {
+        char *from = g_format_size(before);
+        char *to = g_format_size(after);
+        g_debug("Evicted %s cache: %s -> %s", account->name, from, to);
+        g_free(to);
+        g_free(from);
+    }
+}
+
+void memory_budget_enforce(void) {
+    g_mutex_lock(&accounts_lock);
+
+    if (!accounts) {
+        g_mutex_unlock(&accounts_lock);
+        return;
+    }
+
+    // Per-cache budgets first
+    for (guint i = 0; i < accounts->len; i++) {
+        MemoryAccount *account = g_ptr_array_index(accounts, i);
+        evict_account(account, account->budget);
+    }
+
+    // Then trim the largest caches until everything fits the global limit
+    if (memory_budget_get_usage() > global_limit) {
+        GPtrArray *by_size = g_ptr_array_copy(accounts, NULL, NULL);
+        g_ptr_array_sort(by_size, compare_usage_desc);
+
+        for (guint i = 0; i < by_size->len && memory_budget_get_usage() > global_limit; i++) {
+            MemoryAccount *account = g_ptr_array_index(by_size, i);
+            gsize excess = memory_budget_get_usage() - global_limit;
+            gsize usage = memory_account_get_usage(account);
+            evict_account(account, usage > excess ? usage - excess : 0);
+        }
+
+        g_ptr_array_unref(by_size);
+    }
+
+    g_mutex_unlock(&accounts_lock);
+}
+
+static void on_low_memory_warning(GMemoryMonitor *monitor, GMemoryMonitorWarningLevel level,
+                                  gpointer user_data) {
+    memory_budget_shrink(level);
+}
+
+void memory_budget_shrink(GMemoryMonitorWarningLevel level) {
+    // Keep less the more severe the warning is
+    double keep = 0.0;
+    if (level < G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM) {
+        keep = 0.5;
+    } else if (level < G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL) {
+        keep = 0.25;
+    }
+
+    g_printerr("Low memory warning (level %d), shrinking caches to %.0f%%\n", level, keep * 100);
+
+    g_mutex_lock(&accounts_lock);
+    for (guint i = 0; accounts && i < accounts->len; i++) {
+        MemoryAccount *account = g_ptr_array_index(accounts, i);
+        evict_account(account, (gsize)(memory_account_get_usage(account) * keep));
+    }
+    g_mutex_unlock(&accounts_lock);
+}
+
+void memory_budget_watch_pressure(void) {
+    if (memory_monitor) {
+        return;
+    }
+
+    memory_monitor = g_memory_monitor_dup_default();
+    g_signal_connect(memory_monitor, "low-memory-warning",
+                     G_CALLBACK(on_low_memory_warning), NULL);
+}
+
+char *memory_budget_format_status(void) {
+    char *total = g_format_size(memory_budget_get_usage());
+    char *limit = g_format_size(global_limit);
+    GString *status = g_string_new(NULL);
+
+    g_string_printf(status, "Caches %s of %s", total, limit);
+
+    g_mutex_lock(&accounts_lock);
+    for (guint i = 0; accounts && i < accounts->len; i++) {
+        MemoryAccount *account = g_ptr_array_index(accounts, i);
+        char *usage = g_format_size(memory_account_get_usage(account));
+        g_string_append_printf(status, "%s %s %s", i == 0 ? ":" : ",", account->name, usage);
+        g_free(usage);
+    }
+    g_mutex_unlock(&accounts_lock);
+
+    g_free(limit);
+    g_free(total);
+
+    return g_string_free(status, FALSE);
+}
+
+void memory_budget_dump(void) {
+    char *total = g_format_size(memory_budget_get_usage());
+    char *limit = g_format_size(global_limit);
+
+    g_print("Memory budget: %s of %s\n", total, limit);
+
+    g_mutex_lock(&accounts_lock);
+    for (guint i = 0; accounts && i < accounts->len; i++) {
+        MemoryAccount *account = g_ptr_array_index(accounts, i);
+        char *usage = g_format_size(memory_account_get_usage(account));
+        char *budget = g_format_size(account->budget);
+        g_print("  %-12s %12s / %s\n", account->name, usage, budget);
+        g_free(budget);
+        g_free(usage);
+    }
+    g_mutex_unlock(&accounts_lock);
+
+    g_free(limit);
+    g_free(total);
+}
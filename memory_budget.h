@@ -0,0 +1,52 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <gio/gio.h>
+
+// Central accounting for cache memory.
+//
+// Each cache registers an account, reports byte deltas as it grows and
+// shrinks, and provides an evict callback. When a cache goes over its own
+// budget, or all caches together go over the global limit, eviction is
+// coordinated on the main thread: over-budget caches first, then the
+// largest caches until the total fits. GMemoryMonitor warnings shrink
+// every cache.
+
+typedef struct _MemoryAccount MemoryAccount;
+
+// Shrink the cache to at most target_bytes, reporting freed bytes through
+// memory_account_add(). Runs on the main thread, or in headless mode on
+// whichever thread went over budget, and must not register or unregister
+// accounts.
+typedef void (*MemoryEvictFunc)(MemoryAccount *account, gsize target_bytes, gpointer user_data);
+
+MemoryAccount *memory_account_register(const char *name, gsize budget_bytes,
+                                       MemoryEvictFunc evict, gpointer user_data);
+void memory_account_unregister(MemoryAccount *account);
+
+// Thread safe
+void memory_account_add(MemoryAccount *account, gssize delta_bytes);
+gsize memory_account_get_usage(MemoryAccount *account);
+
+void memory_budget_set_limit(gsize limit_bytes);
+gsize memory_budget_get_limit(void);
+
+// Headless batch modes run without a main loop: evict right away on the
+// thread whose charge went over budget instead of from an idle. Only for
+// processes whose evict callbacks are all thread safe. Memory must not be
+// charged while holding a lock the cache's evict callback takes.
+void memory_budget_set_headless(gboolean headless);
+gsize memory_budget_get_usage(void);
+
+// Main thread
+void memory_budget_enforce(void);
+void memory_budget_watch_pressure(void);
+// What a GMemoryMonitor warning triggers: every cache keeps half its usage
+// below MEDIUM, a quarter below CRITICAL and nothing at CRITICAL
+void memory_budget_shrink(GMemoryMonitorWarningLevel level);
+
+// "Caches 120.5 MB of 512.0 MB: layers 100.0 MB, media 20.5 MB"
+char *memory_budget_format_status(void);
+void memory_budget_dump(void);
+
+#endif
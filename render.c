@@ -0,0 +1,412 @@
+#include "render.h"
+#include "import.h"
+#include <cairo-pdf.h>
+#include <pango/pangocairo.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define SLIDE_MARGIN 64
+#define TITLE_FONT "Sans Bold 40"
+#define BODY_FONT "Sans 24"
+#define MIN_IMAGE_HEIGHT 80
+
+typedef struct {
+    Deck *deck;
+    char *output_stem;
+    gint pending_slides;
+} RenderDeck;
+
+// Either loads a deck (deck == NULL) or renders one of its slides to PNG
+typedef struct {
+    RenderDeck *deck;
+    guint slide;
+    char *input_path;
+    char *output_stem;
+} RenderJob;
+
+typedef struct {
+    GThreadPool *pool;
+    RenderFormat format;
+    GMutex lock;
+    GCond done;
+    gint outstanding;
+    guint slides;
+    guint failed;
+    gint64 total_us;
+    gint64 max_us;
+} RenderState;
+
+// Static helper functions
+static void draw_texture(cairo_t *cr, GdkTexture *texture, double x, double y,
+                         double width, double height);
+static void collect_decks(const char *input_dir, const char *output_dir, GPtrArray *jobs);
+static Deck *load_deck(const char *path, GError **error);
+static gint compare_jobs(gconstpointer a, gconstpointer b, gpointer user_data);
+static void push_job(RenderState *state, RenderJob *job);
+static void finish_job(RenderState *state, RenderJob *job);
+static void report_slide(RenderState *state, const char *stem, guint index,
+                         gint64 elapsed_us, gboolean ok);
+static void render_deck_unref(RenderDeck *deck);
+static void render_png(RenderState *state, RenderJob *job);
+static void render_pdf(RenderState *state, RenderDeck *deck);
+static void render_worker(gpointer data, gpointer user_data);
+
+static void draw_texture(cairo_t *cr, GdkTexture *texture, double x, double y,
+                         double width, double height) {
+    int tex_width = gdk_texture_get_width(texture);
+    int tex_height = gdk_texture_get_height(texture);
+
+    // GDK_MEMORY_DEFAULT matches CAIRO_FORMAT_ARGB32
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, tex_width, tex_height);
+    cairo_surface_flush(surface);
+    gdk_texture_download(texture, cairo_image_surface_get_data(surface),
+                         cairo_image_surface_get_stride(surface));
+    cairo_surface_mark_dirty(surface);
+
+    double scale = MIN(width / tex_width, height / tex_height);
+
+    cairo_save(cr);
+    cairo_translate(cr, x + (width - tex_width * scale) / 2, y + (height - tex_height * scale) / 2);
+    cairo_scale(cr, scale, scale);
+    cairo_set_source_surface(cr, surface, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    cairo_surface_destroy(surface);
+}
+
+void render_slide(cairo_t *cr, Deck *deck, Slide *slide, double width, double height) {
+    double scale = MIN(width / SLIDE_WIDTH, height / SLIDE_HEIGHT);
+    double y = SLIDE_MARGIN;
+
+    cairo_save(cr);
+    cairo_scale(cr, scale, scale);
+    cairo_rectangle(cr, 0, 0, SLIDE_WIDTH, SLIDE_HEIGHT);
+    cairo_clip(cr);
+
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_paint(cr);
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+
+    PangoLayout *layout = pango_cairo_create_layout(cr);
+    pango_layout_set_width(layout, (SLIDE_WIDTH - 2 * SLIDE_MARGIN) * PANGO_SCALE);
+    pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+
+    PangoFontDescription *font = pango_font_description_from_string(TITLE_FONT);
+    pango_layout_set_font_description(layout, font);
+    pango_font_description_free(font);
+
+    gboolean title_skipped = FALSE;
+    int text_width, text_height;
+
+    if (slide->title) {
+        pango_layout_set_text(layout, slide->title, -1);
+        cairo_move_to(cr, SLIDE_MARGIN, y);
+        pango_cairo_show_layout(cr, layout);
+        pango_layout_get_pixel_size(layout, &text_width, &text_height);
+        y += text_height + 24;
+    }
+
+    font = pango_font_description_from_string(BODY_FONT);
+    pango_layout_set_font_description(layout, font);
+    pango_font_description_free(font);
+
+    for (guint i = 0; i < slide->paragraphs->len && y < SLIDE_HEIGHT - SLIDE_MARGIN; i++) {
+        const char *paragraph = g_ptr_array_index(slide->paragraphs, i);
+
+        // The title is also one of the paragraphs, don't draw it twice
+        if (!title_skipped && g_strcmp0(paragraph, slide->title) == 0) {
+            title_skipped = TRUE;
+            continue;
+        }
+
+        char *bullet = g_strdup_printf("• %s", paragraph);
+        pango_layout_set_text(layout, bullet, -1);
+        cairo_move_to(cr, SLIDE_MARGIN, y);
+        pango_cairo_show_layout(cr, layout);
+        pango_layout_get_pixel_size(layout, &text_width, &text_height);
+        y += text_height + 12;
+        g_free(bullet);
+    }
+
+    g_object_unref(layout);
+
+    // Images share whatever room the text left, side by side
+    double image_height = SLIDE_HEIGHT - SLIDE_MARGIN - y;
+    if (slide->media->len > 0 && image_height >= MIN_IMAGE_HEIGHT) {
+        double slot = (SLIDE_WIDTH - 2.0 * SLIDE_MARGIN) / slide->media->len;
+
+        for (guint i = 0; i < slide->media->len; i++) {
+            DeckMedia *media = deck_get_media(deck, g_ptr_array_index(slide->media, i));
+            GdkTexture *texture = media ? deck_media_get_texture(media, NULL) : NULL;
+            if (texture) {
+                draw_texture(cr, texture, SLIDE_MARGIN + i * slot, y, slot - 8, image_height);
+                g_object_unref(texture);
+            }
+        }
+    }
+
+    cairo_restore(cr);
+}
+
+static Deck *load_deck(const char *path, GError **error) {
+    if (g_str_has_suffix(path, ".present")) {
+        return deck_load(path, error);
+    }
+    return import_deck(path, error);
+}
+
+static void collect_decks(const char *input_dir, const char *output_dir, GPtrArray *jobs) {
+    static const char * const suffixes[] = { ".pptx", ".odp", ".present", NULL };
+    GPtrArray *files = deck_find_files(input_dir, suffixes);
+    GHashTable *found = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (guint i = 0; i < files->len; i++) {
+        g_hash_table_add(found, g_ptr_array_index(files, i));
+    }
+
+    for (guint i = 0; i < files->len; i++) {
+        const char *relative = g_ptr_array_index(files, i);
+
+        // talk.pptx.present is the imported copy of talk.pptx, render the
+        // deck once
+        if (g_str_has_suffix(relative, ".present")) {
+            char *source = g_strndup(relative, strlen(relative) - strlen(".present"));
+            gboolean duplicate = g_hash_table_contains(found, source);
+            g_free(source);
+            if (duplicate) {
+                continue;
+            }
+        }
+
+        // Keep the extension so talk.pptx and talk.odp don't share outputs
+        RenderJob *job = g_new0(RenderJob, 1);
+        job->input_path = g_build_filename(input_dir, relative, NULL);
+        job->output_stem = g_build_filename(output_dir, relative, NULL);
+        g_ptr_array_add(jobs, job);
+    }
+
+    g_hash_table_destroy(found);
+    g_ptr_array_unref(files);
+}
+
+// Slide jobs before deck loads: otherwise the FIFO pool loads every deck in
+// the tree before rendering a single slide, and peak memory grows with the
+// input directory instead of the worker count
+static gint compare_jobs(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const RenderJob *x = (const RenderJob *)a;
+    const RenderJob *y = (const RenderJob *)b;
+    return (x->deck == NULL) - (y->deck == NULL);
+}
+
+static void push_job(RenderState *state, RenderJob *job) {
+    g_atomic_int_inc(&state->outstanding);
+    g_thread_pool_push(state->pool, job, NULL);
+}
+
+static void finish_job(RenderState *state, RenderJob *job) {
+    g_free(job->input_path);
+    g_free(job->output_stem);
+    g_free(job);
+
+    if (g_atomic_int_dec_and_test(&state->outstanding)) {
+        g_mutex_lock(&state->lock);
+        g_cond_signal(&state->done);
+        g_mutex_unlock(&state->lock);
+    }
+}
+
+static void report_slide(RenderState *state, const char *stem, guint index,
+                         gint64 elapsed_us, gboolean ok) {
+    g_print("%s slide %u: %.2f ms%s\n", stem, index + 1, elapsed_us / 1000.0, ok ? "" : " (failed)");
+
+    g_mutex_lock(&state->lock);
+    state->slides++;
+    state->total_us += elapsed_us;
+    state->max_us = MAX(state->max_us, elapsed_us);
+    if (!ok) {
+        state->failed++;
+    }
+    g_mutex_unlock(&state->lock);
+}
+
+static void render_deck_unref(RenderDeck *deck) {
+    if (g_atomic_int_dec_and_test(&deck->pending_slides)) {
+        deck_free(deck->deck);
+        g_free(deck->output_stem);
+        g_free(deck);
+    }
+}
+
+static void render_png(RenderState *state, RenderJob *job) {
+    RenderDeck *deck = job->deck;
+    Slide *slide = g_ptr_array_index(deck->deck->slides, job->slide);
+    gint64 start = g_get_monotonic_time();
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, SLIDE_WIDTH, SLIDE_HEIGHT);
+    cairo_t *cr = cairo_create(surface);
+    render_slide(cr, deck->deck, slide, SLIDE_WIDTH, SLIDE_HEIGHT);
+    cairo_destroy(cr);
+
+    char *path = g_strdup_printf("%s-%03u.png", deck->output_stem, job->slide + 1);
+    cairo_status_t status = cairo_surface_write_to_png(surface, path);
+    cairo_surface_destroy(surface);
+
+    report_slide(state, deck->output_stem, job->slide, g_get_monotonic_time() - start,
+                 status == CAIRO_STATUS_SUCCESS);
+    g_free(path);
+
+    render_deck_unref(deck);
+}
+
+static void render_pdf(RenderState *state, RenderDeck *deck) {
+    // Pages of one PDF are sequential; concurrency comes from decks
+    char *path = g_strdup_printf("%s.pdf", deck->output_stem);
+    cairo_surface_t *surface = cairo_pdf_surface_create(path, SLIDE_WIDTH, SLIDE_HEIGHT);
+    cairo_t *cr = cairo_create(surface);
+
+    for (guint i = 0; i < deck->deck->slides->len; i++) {
+        gint64 start = g_get_monotonic_time();
+        render_slide(cr, deck->deck, g_ptr_array_index(deck->deck->slides, i),
+                     SLIDE_WIDTH, SLIDE_HEIGHT);
+        cairo_show_page(cr);
+        report_slide(state, deck->output_stem, i, g_get_monotonic_time() - start,
+                     cairo_status(cr) == CAIRO_STATUS_SUCCESS);
+    }
+
+    cairo_destroy(cr);
+    cairo_surface_finish(surface);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        g_printerr("Failed to write %s\n", path);
+        g_mutex_lock(&state->lock);
+        state->failed++;
+        g_mutex_unlock(&state->lock);
+    }
+    cairo_surface_destroy(surface);
+    g_free(path);
+}
+
+static void render_worker(gpointer data, gpointer user_data) {
+    RenderJob *job = (RenderJob *)data;
+    RenderState *state = (RenderState *)user_data;
+
+    if (job->deck) {
+        render_png(state, job);
+        finish_job(state, job);
+        return;
+    }
+
+    GError *error = NULL;
+    Deck *deck = load_deck(job->input_path, &error);
+    if (!deck) {
+        g_printerr("Failed to load %s: %s\n", job->input_path, error->message);
+        g_error_free(error);
+        g_mutex_lock(&state->lock);
+        state->failed++;
+        g_mutex_unlock(&state->lock);
+        finish_job(state, job);
+        return;
+    }
+
+    char *dir = g_path_get_dirname(job->output_stem);
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    RenderDeck *render_deck = g_new0(RenderDeck, 1);
+    render_deck->deck = deck;
+    render_deck->output_stem = g_strdup(job->output_stem);
+
+    if (state->format == RENDER_FORMAT_PDF || deck->slides->len == 0) {
+        render_deck->pending_slides = 1;
+        if (state->format == RENDER_FORMAT_PDF) {
+            render_pdf(state, render_deck);
+        }
+        render_deck_unref(render_deck);
+    } else {
+        // Fan slides out to the same bounded pool
+        render_deck->pending_slides = deck->slides->len;
+        for (guint i = 0; i < deck->slides->len; i++) {
+            RenderJob *slide_job = g_new0(RenderJob, 1);
+            slide_job->deck = render_deck;
+            slide_job->slide = i;
+            push_job(state, slide_job);
+        }
+    }
+
+    finish_job(state, job);
+}
+
+int render_batch(const char *input, const char *output_dir,
+                 RenderFormat format, guint n_jobs) {
+    GPtrArray *jobs = g_ptr_array_new();
+    RenderState state = { .format = format };
+    GError *error = NULL;
+
+    if (g_file_test(input, G_FILE_TEST_IS_DIR)) {
+        collect_decks(input, output_dir, jobs);
+    } else {
+        RenderJob *job = g_new0(RenderJob, 1);
+        char *base = g_path_get_basename(input);
+        job->input_path = g_strdup(input);
+        job->output_stem = g_build_filename(output_dir, base, NULL);
+        g_ptr_array_add(jobs, job);
+        g_free(base);
+    }
+
+    if (jobs->len == 0) {
+        g_printerr("No decks found in %s\n", input);
+        g_ptr_array_unref(jobs);
+        return 1;
+    }
+
+    if (n_jobs == 0) {
+        n_jobs = g_get_num_processors();
+    }
+
+    g_mutex_init(&state.lock);
+    g_cond_init(&state.done);
+    state.pool = g_thread_pool_new(render_worker, &state, n_jobs, TRUE, &error);
+    if (!state.pool) {
+        g_printerr("Failed to start workers: %s\n", error->message);
+        g_error_free(error);
+        for (guint i = 0; i < jobs->len; i++) {
+            RenderJob *job = g_ptr_array_index(jobs, i);
+            g_free(job->input_path);
+            g_free(job->output_stem);
+            g_free(job);
+        }
+        g_ptr_array_unref(jobs);
+        return 1;
+    }
+
+    g_thread_pool_set_sort_function(state.pool, compare_jobs, NULL);
+
+    g_print("Rendering %u decks with %u workers\n", jobs->len, n_jobs);
+    gint64 start = g_get_monotonic_time();
+
+    for (guint i = 0; i < jobs->len; i++) {
+        push_job(&state, g_ptr_array_index(jobs, i));
+    }
+
+    // Workers push slide jobs of their own, so wait for the count to drain
+    // rather than freeing the pool straight away
+    g_mutex_lock(&state.lock);
+    while (g_atomic_int_get(&state.outstanding) > 0) {
+        g_cond_wait(&state.done, &state.lock);
+    }
+    g_mutex_unlock(&state.lock);
+
+    g_thread_pool_free(state.pool, FALSE, TRUE);
+
+    double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    g_print("Rendered %u slides in %.2f s (%.1f slides/sec), mean %.2f ms, max %.2f ms, %u failed\n",
+            state.slides, elapsed, elapsed > 0 ? state.slides / elapsed : 0.0,
+            state.slides > 0 ? state.total_us / 1000.0 / state.slides : 0.0,
+            state.max_us / 1000.0, state.failed);
+
+    g_mutex_clear(&state.lock);
+    g_cond_clear(&state.done);
+    g_ptr_array_unref(jobs);
+
+    return state.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <cairo.h>
+#include "deck.h"
+
+// Offscreen slide rendering straight to Cairo, no display or GtkWindow
+// involved, so it can run on headless servers and from worker threads.
+
+#define SLIDE_WIDTH 1280
+#define SLIDE_HEIGHT 720
+
+typedef enum {
+    RENDER_FORMAT_PNG,
+    RENDER_FORMAT_PDF
+} RenderFormat;
+
+// Draws one slide scaled to fit width x height
+void render_slide(cairo_t *cr, Deck *deck, Slide *slide, double width, double height);
+
+// Renders a deck file, or every deck below a directory, into output_dir:
+// one PNG per slide (talk.pptx-001.png) or one multi-page PDF per deck
+// (talk.pptx.pdf). Outputs keep the source extension so decks differing
+// only in format don't collide, and an imported talk.pptx.present is
+// skipped when talk.pptx is rendered too. Up to n_jobs slides or
+// decks are rendered concurrently and each slide's render time is printed.
+// Returns a process exit code.
+int render_batch(const char *input, const char *output_dir,
+                 RenderFormat format, guint n_jobs);
+
+#endif
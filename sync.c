@@ -0,0 +1,543 @@
+#include "sync.h"
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+
+// Wire format, one line per position update:
+//   P <seq> <slide> <timeline_us> <sent_us> <playing>\n
+// sent_us is g_get_monotonic_time() on the leader. Leader and followers run
+// on the same host (unix or loopback socket), so they share CLOCK_MONOTONIC
+// and the difference is the real transport latency.
+#define SYNC_MESSAGE_MAX 96
+
+// Followers started before their leader, or whose leader restarted, keep
+// trying at this interval
+#define SYNC_RECONNECT_INTERVAL_MS 500
+
+// A connected follower as seen from the leader
+typedef struct {
+    SyncLeader *leader;
+    GSocketConnection *connection;
+    GSource *writable_source; // Set while an update was skipped on a full socket
+} LeaderPeer;
+
+struct _SyncLeader {
+    GSocketService *service;
+    GSocketAddress *address;
+    GPtrArray *followers; // LeaderPeer*
+    guint64 seq;
+    gboolean has_position;
+    guint slide;
+    gint64 timeline_us;
+    gint64 sent_us;
+    gboolean playing;
+};
+
+struct _SyncFollower {
+    GSocketAddress *address;
+    GSocketClient *client;
+    GSocketConnection *connection; // NULL while (re)connecting
+    GDataInputStream *input;
+    GCancellable *cancellable;
+    guint reconnect_id;
+    gboolean reported_unreachable;
+    GtkWidget *clock_widget;
+    guint tick_id;
+    SyncPositionFunc func;
+    gpointer user_data;
+    guint64 last_seq;
+    // Newest position not yet shown; older ones are simply overwritten
+    gboolean has_pending;
+    guint pending_slide;
+    gint64 pending_timeline_us;
+    gint64 pending_sent_us;
+    gboolean pending_playing;
+    SyncLatencyStats transport;
+    SyncLatencyStats end_to_end;
+};
+
+// Static helper functions
+static GSocketAddress *parse_address(const char *address, GError **error);
+static gboolean claim_unix_path(GUnixSocketAddress *address, GError **error);
+static void set_low_latency(GSocketConnection *connection);
+static gsize format_position(SyncLeader *leader, char *buffer, gsize size);
+static void leader_peer_free(LeaderPeer *peer);
+static gboolean send_to_follower(LeaderPeer *peer, const char *msg, gsize len);
+static gboolean on_follower_writable(GSocket *socket, GIOCondition condition, gpointer user_data);
+static gboolean on_incoming(GSocketService *service, GSocketConnection *connection,
+                            GObject *source_object, gpointer user_data);
+static void start_connect(SyncFollower *follower);
+static void on_connected(GObject *source, GAsyncResult *result, gpointer user_data);
+static void drop_connection(SyncFollower *follower);
+static void schedule_reconnect(SyncFollower *follower);
+static gboolean on_reconnect_timeout(gpointer user_data);
+static void read_next_line(SyncFollower *follower);
+static void on_line_read(GObject *source, GAsyncResult *result, gpointer user_data);
+static gboolean on_follower_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data);
+static void apply_pending(SyncFollower *follower, gint64 target_time);
+static void latency_add(SyncLatencyStats *stats, gint64 value_us);
+
+static GSocketAddress *parse_address(const char *address, GError **error) {
+    if (g_str_has_prefix(address, "unix:")) {
+        return g_unix_socket_address_new(address + strlen("unix:"));
+    }
+
+    char *end = NULL;
+    guint64 port = g_ascii_strtoull(address, &end, 10);
+    if (end != address && *end == '\0' && port > 0 && port <= G_MAXUINT16) {
+        // Loopback only, sync is never exposed to the network
+        GInetAddress *loopback = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+        GSocketAddress *socket_address = g_inet_socket_address_new(loopback, (guint16)port);
+        g_object_unref(loopback);
+        return socket_address;
+    }
+
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                "Invalid sync address '%s' (expected unix:PATH or a port)", address);
+    return NULL;
+}
+
+static void set_low_latency(GSocketConnection *connection) {
+    GSocket *socket = g_socket_connection_get_socket(connection);
+
+    if (g_socket_get_family(socket) != G_SOCKET_FAMILY_UNIX) {
+        // Messages are tiny, don't let Nagle hold them back
+        g_socket_set_option(socket, IPPROTO_TCP, TCP_NODELAY, 1, NULL);
+    }
+}
+
+// ===== Leader =====
+
+static gboolean claim_unix_path(GUnixSocketAddress *address, GError **error) {
+    const char *path = g_unix_socket_address_get_path(address);
+    GSocketClient *client = g_socket_client_new();
+    GError *connect_error = NULL;
+
+    // A socket file nobody listens on is left over from a crashed run and
+    // may be replaced; a live leader must not be silently displaced
+    GSocketConnection *connection = g_socket_client_connect(client, G_SOCKET_CONNECTABLE(address),
+                                                            NULL, &connect_error);
+    g_object_unref(client);
+
+    if (connection) {
+        g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+        g_object_unref(connection);
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE,
+                    "Another sync leader is already listening on %s", path);
+        return FALSE;
+    }
+
+    if (g_error_matches(connect_error, G_IO_ERROR, G_IO_ERROR_CONNECTION_REFUSED)) {
+        g_unlink(path);
+    }
+    g_error_free(connect_error);
+
+    return TRUE;
+}
+
+SyncLeader *sync_leader_new(const char *address, GError **error) {
+    GSocketAddress *socket_address = parse_address(address, error);
+    if (!socket_address) {
+        return NULL;
+    }
+
+    if (G_IS_UNIX_SOCKET_ADDRESS(socket_address) &&
+        !claim_unix_path(G_UNIX_SOCKET_ADDRESS(socket_address), error)) {
+        g_object_unref(socket_address);
+        return NULL;
+    }
+
+    SyncLeader *leader = g_new0(SyncLeader, 1);
+    leader->followers = g_ptr_array_new_with_free_func((GDestroyNotify)leader_peer_free);
+    leader->service = g_socket_service_new();
+
+    if (!g_socket_listener_add_address(G_SOCKET_LISTENER(leader->service), socket_address,
+                                       G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                       NULL, NULL, error)) {
+        // Not ours, so sync_leader_free() must not unlink it
+        g_object_unref(socket_address);
+        sync_leader_free(leader);
+        return NULL;
+    }
+    leader->address = socket_address;
+
+    g_signal_connect(leader->service, "incoming", G_CALLBACK(on_incoming), leader);
+    g_socket_service_start(leader->service);
+
+    g_print("Sync leader listening on %s\n", address);
+    return leader;
+}
+
+static gsize format_position(SyncLeader *leader, char *buffer, gsize size) {
+    gint64 now = g_get_monotonic_time();
+    gint64 timeline_us = leader->timeline_us;
+
+    // Re-stamp so late joiners don't count the time since the last advance
+    // as transport latency
+    if (leader->playing) {
+        timeline_us += now - leader->sent_us;
+    }
+
+    return g_snprintf(buffer, size,
+                      "P %" G_GUINT64_FORMAT " %u %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %d\n",
+                      leader->seq, leader->slide, timeline_us, now, leader->playing ? 1 : 0);
+}
+
+static void leader_peer_free(LeaderPeer *peer) {
+    if (peer) {
+        if (peer->writable_source) {
+            g_source_destroy(peer->writable_source);
+            g_source_unref(peer->writable_source);
+        }
+        g_object_unref(peer->connection);
+        g_free(peer);
+    }
+}
+
+static gboolean send_to_follower(LeaderPeer *peer, const char *msg, gsize len) {
+    GSocket *socket = g_socket_connection_get_socket(peer->connection);
+    GError *error = NULL;
+
+    gssize sent = g_socket_send(socket, msg, len, NULL, &error);
+    if (sent < 0) {
+        if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+            // Follower is not keeping up; skip this update and send the
+            // newest position once the socket drains, so the last advance
+            // always arrives
+            g_error_free(error);
+            if (!peer->writable_source) {
+                peer->writable_source = g_socket_create_source(socket, G_IO_OUT, NULL);
+                g_source_set_callback(peer->writable_source,
+                                      G_SOURCE_FUNC(on_follower_writable),
+                                      peer, NULL);
+                g_source_attach(peer->writable_source, NULL);
+            }
+            return TRUE;
+        }
+        g_print("Dropping sync follower: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    if ((gsize)sent < len) {
+        // A partial line would desynchronise framing for this follower
+        g_print("Dropping sync follower: short write\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean on_follower_writable(GSocket *socket, GIOCondition condition, gpointer user_data) {
+    LeaderPeer *peer = (LeaderPeer *)user_data;
+    SyncLeader *leader = peer->leader;
+    char msg[SYNC_MESSAGE_MAX];
+
+    // Detach first so a still-full socket can arm a fresh watch
+    g_source_unref(peer->writable_source);
+    peer->writable_source = NULL;
+
+    gsize len = format_position(leader, msg, sizeof(msg));
+    if (!send_to_follower(peer, msg, len)) {
+        g_ptr_array_remove_fast(leader->followers, peer);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean on_incoming(GSocketService *service, GSocketConnection *connection,
+                            GObject *source_object, gpointer user_data) {
+    SyncLeader *leader = (SyncLeader *)user_data;
+
+    // The leader must never stall on a slow follower
+    g_socket_set_blocking(g_socket_connection_get_socket(connection), FALSE);
+    set_low_latency(connection);
+
+    LeaderPeer *peer = g_new0(LeaderPeer, 1);
+    peer->leader = leader;
+    peer->connection = g_object_ref(connection);
+
+    if (leader->has_position) {
+        char msg[SYNC_MESSAGE_MAX];
+        gsize len = format_position(leader, msg, sizeof(msg));
+        if (!send_to_follower(peer, msg, len)) {
+            leader_peer_free(peer);
+            return TRUE;
+        }
+    }
+
+    g_ptr_array_add(leader->followers, peer);
+    g_print("Sync follower connected (%u total)\n", leader->followers->len);
+
+    return TRUE;
+}
+
+void sync_leader_broadcast(SyncLeader *leader, guint slide,
+                           gint64 timeline_us, gboolean playing) {
+    leader->seq++;
+    leader->has_position = TRUE;
+    leader->slide = slide;
+    leader->timeline_us = timeline_us;
+    leader->sent_us = g_get_monotonic_time();
+    leader->playing = playing;
+
+    char msg[SYNC_MESSAGE_MAX];
+    gsize len = format_position(leader, msg, sizeof(msg));
+
+    for (guint i = 0; i < leader->followers->len; ) {
+        LeaderPeer *peer = g_ptr_array_index(leader->followers, i);
+        // Followers that are behind get the newest position when writable
+        if (peer->writable_source || send_to_follower(peer, msg, len)) {
+            i++;
+        } else {
+            g_ptr_array_remove_index_fast(leader->followers, i);
+        }
+    }
+}
+
+guint sync_leader_get_follower_count(SyncLeader *leader) {
+    return leader->followers->len;
+}
+
+void sync_leader_free(SyncLeader *leader) {
+    if (leader) {
+        if (leader->service) {
+            g_socket_service_stop(leader->service);
+            g_socket_listener_close(G_SOCKET_LISTENER(leader->service));
+            g_object_unref(leader->service);
+        }
+        if (leader->address) {
+            if (G_IS_UNIX_SOCKET_ADDRESS(leader->address)) {
+                g_unlink(g_unix_socket_address_get_path(G_UNIX_SOCKET_ADDRESS(leader->address)));
+            }
+            g_object_unref(leader->address);
+        }
+        g_ptr_array_unref(leader->followers);
+        g_free(leader);
+    }
+}
+
+// ===== Follower =====
+
+SyncFollower *sync_follower_new(const char *address, GtkWidget *clock_widget,
+                                SyncPositionFunc func, gpointer user_data,
+                                GError **error) {
+    GSocketAddress *socket_address = parse_address(address, error);
+    if (!socket_address) {
+        return NULL;
+    }
+
+    SyncFollower *follower = g_new0(SyncFollower, 1);
+    follower->address = socket_address;
+    follower->client = g_socket_client_new();
+    follower->cancellable = g_cancellable_new();
+    follower->clock_widget = clock_widget ? g_object_ref(clock_widget) : NULL;
+    follower->func = func;
+    follower->user_data = user_data;
+
+    start_connect(follower);
+
+    return follower;
+}
+
+static void start_connect(SyncFollower *follower) {
+    g_socket_client_connect_async(follower->client, G_SOCKET_CONNECTABLE(follower->address),
+                                  follower->cancellable, on_connected, follower);
+}
+
+static void on_connected(GObject *source, GAsyncResult *result, gpointer user_data) {
+    GError *error = NULL;
+    GSocketConnection *connection = g_socket_client_connect_finish(G_SOCKET_CLIENT(source),
+                                                                   result, &error);
+
+    if (!connection) {
+        // On cancellation the follower has already been freed
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            SyncFollower *follower = (SyncFollower *)user_data;
+            if (!follower->reported_unreachable) {
+                g_print("Sync leader not reachable (%s), retrying\n", error->message);
+                follower->reported_unreachable = TRUE;
+            }
+            schedule_reconnect(follower);
+        }
+        g_error_free(error);
+        return;
+    }
+
+    SyncFollower *follower = (SyncFollower *)user_data;
+    set_low_latency(connection);
+
+    follower->connection = connection;
+    follower->input = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+    g_data_input_stream_set_newline_type(follower->input, G_DATA_STREAM_NEWLINE_TYPE_LF);
+    // A restarted leader numbers its messages from the beginning again
+    follower->last_seq = 0;
+    follower->reported_unreachable = FALSE;
+
+    read_next_line(follower);
+
+    g_print("Sync follower connected\n");
+}
+
+static void drop_connection(SyncFollower *follower) {
+    if (follower->connection) {
+        g_io_stream_close(G_IO_STREAM(follower->connection), NULL, NULL);
+        g_clear_object(&follower->input);
+        g_clear_object(&follower->connection);
+    }
+}
+
+static void schedule_reconnect(SyncFollower *follower) {
+    if (follower->reconnect_id == 0) {
+        follower->reconnect_id = g_timeout_add(SYNC_RECONNECT_INTERVAL_MS,
+                                               on_reconnect_timeout, follower);
+    }
+}
+
+static gboolean on_reconnect_timeout(gpointer user_data) {
+    SyncFollower *follower = (SyncFollower *)user_data;
+
+    follower->reconnect_id = 0;
+    start_connect(follower);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void read_next_line(SyncFollower *follower) {
+    g_data_input_stream_read_line_async(follower->input, G_PRIORITY_HIGH,
+                                        follower->cancellable, on_line_read, follower);
+}
+
+static void on_line_read(GObject *source, GAsyncResult *result, gpointer user_data) {
+    GError *error = NULL;
+    char *line = g_data_input_stream_read_line_finish(G_DATA_INPUT_STREAM(source), result,
+                                                      NULL, &error);
+
+    if (!line) {
+        // On cancellation the follower has already been freed
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            SyncFollower *follower = (SyncFollower *)user_data;
+            g_print("Sync leader disconnected%s%s, reconnecting\n",
+                    error ? ": " : "", error ? error->message : "");
+            drop_connection(follower);
+            schedule_reconnect(follower);
+        }
+        g_clear_error(&error);
+        return;
+    }
+
+    SyncFollower *follower = (SyncFollower *)user_data;
+    guint64 seq;
+    guint slide;
+    gint64 timeline_us, sent_us;
+    int playing;
+
+    if (sscanf(line, "P %" G_GUINT64_FORMAT " %u %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %d",
+               &seq, &slide, &timeline_us, &sent_us, &playing) == 5 &&
+        seq > follower->last_seq) {
+        follower->last_seq = seq;
+        latency_add(&follower->transport, g_get_monotonic_time() - sent_us);
+
+        follower->has_pending = TRUE;
+        follower->pending_slide = slide;
+        follower->pending_timeline_us = timeline_us;
+        follower->pending_sent_us = sent_us;
+        follower->pending_playing = playing != 0;
+
+        if (follower->clock_widget) {
+            // Schedule against the follower's own frame clock
+            if (follower->tick_id == 0) {
+                follower->tick_id = gtk_widget_add_tick_callback(follower->clock_widget,
+                                                                 on_follower_tick,
+                                                                 follower, NULL);
+            }
+        } else {
+            apply_pending(follower, g_get_monotonic_time());
+        }
+    } else {
+        g_print("Ignoring sync message: %s\n", line);
+    }
+
+    g_free(line);
+    read_next_line(follower);
+}
+
+static gboolean on_follower_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data) {
+    SyncFollower *follower = (SyncFollower *)user_data;
+    gint64 frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+    gint64 interval = 0, presentation_time = 0;
+
+    // Compensate up to when this frame actually reaches the screen
+    gdk_frame_clock_get_refresh_info(frame_clock, frame_time, &interval, &presentation_time);
+    if (presentation_time <= 0) {
+        presentation_time = frame_time + interval;
+    }
+
+    follower->tick_id = 0;
+    apply_pending(follower, presentation_time);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void apply_pending(SyncFollower *follower, gint64 target_time) {
+    if (!follower->has_pending) {
+        return;
+    }
+    follower->has_pending = FALSE;
+
+    gint64 timeline_us = follower->pending_timeline_us;
+    if (follower->pending_playing) {
+        timeline_us += target_time - follower->pending_sent_us;
+    }
+
+    latency_add(&follower->end_to_end, target_time - follower->pending_sent_us);
+
+    if (follower->func) {
+        follower->func(follower->pending_slide, timeline_us, follower->user_data);
+    }
+}
+
+static void latency_add(SyncLatencyStats *stats, gint64 value_us) {
+    if (stats->samples == 0 || value_us < stats->min_us) {
+        stats->min_us = value_us;
+    }
+    if (stats->samples == 0 || value_us > stats->max_us) {
+        stats->max_us = value_us;
+    }
+    stats->samples++;
+    stats->mean_us += ((double)value_us - stats->mean_us) / stats->samples;
+}
+
+void sync_follower_get_latency(SyncFollower *follower,
+                               SyncLatencyStats *transport,
+                               SyncLatencyStats *end_to_end) {
+    if (transport) {
+        *transport = follower->transport;
+    }
+    if (end_to_end) {
+        *end_to_end = follower->end_to_end;
+    }
+}
+
+void sync_follower_free(SyncFollower *follower) {
+    if (follower) {
+        g_cancellable_cancel(follower->cancellable);
+        if (follower->reconnect_id > 0) {
+            g_source_remove(follower->reconnect_id);
+        }
+        if (follower->clock_widget) {
+            if (follower->tick_id > 0) {
+                gtk_widget_remove_tick_callback(follower->clock_widget, follower->tick_id);
+            }
+            g_object_unref(follower->clock_widget);
+        }
+        drop_connection(follower);
+        g_object_unref(follower->client);
+        g_object_unref(follower->address);
+        g_object_unref(follower->cancellable);
+        g_free(follower);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <gtk/gtk.h>
+
+// Live presentation sync: one leader broadcasts slide/timeline position,
+// followers replay it against their own frame clocks. Only positions travel
+// over the socket, never slide content.
+//
+// Addresses are either "unix:/path/to/socket" or a bare TCP port number,
+// which binds/connects on the loopback interface only.
+
+typedef struct _SyncLeader SyncLeader;
+typedef struct _SyncFollower SyncFollower;
+
+// Called on the follower when a position should be shown. timeline_us is
+// already latency compensated for the frame it is applied in.
+typedef void (*SyncPositionFunc)(guint slide, gint64 timeline_us, gpointer user_data);
+
+typedef struct {
+    guint samples;
+    gint64 min_us;
+    gint64 max_us;
+    double mean_us;
+} SyncLatencyStats;
+
+// Leader side. Fails if another leader is live on the same unix socket.
+SyncLeader *sync_leader_new(const char *address, GError **error);
+void sync_leader_broadcast(SyncLeader *leader, guint slide,
+                           gint64 timeline_us, gboolean playing);
+guint sync_leader_get_follower_count(SyncLeader *leader);
+void sync_leader_free(SyncLeader *leader);
+
+// Follower side. clock_widget may be NULL, in which case positions are
+// applied as soon as they arrive instead of on the next frame. Connects in
+// the background and keeps reconnecting while the leader is not running,
+// so followers and leader can be started in any order. Only an invalid
+// address is reported through error.
+SyncFollower *sync_follower_new(const char *address, GtkWidget *clock_widget,
+                                SyncPositionFunc func, gpointer user_data,
+                                GError **error);
+void sync_follower_get_latency(SyncFollower *follower,
+                               SyncLatencyStats *transport,
+                               SyncLatencyStats *end_to_end);
+void sync_follower_free(SyncFollower *follower);
+
+#endif
@@ -0,0 +1,174 @@
+#include "animation_queue.h"
+#include <stdlib.h>
+
+// Stress test for the animation command queue: many producer threads push
+// commands and the queue wakes the main loop to drain them by itself.
+// Checks that every command runs exactly once, in per-producer order, and
+// reports push-to-run latency.
+//
+//   ./test_animation_queue [producers] [commands-per-producer]
+
+#define DEFAULT_PRODUCERS 16
+#define DEFAULT_COMMANDS 20000
+#define CHECK_INTERVAL_MS 16
+#define TEST_TIMEOUT_S 60
+
+typedef struct {
+    AnimationQueue *queue;
+    GMainLoop *loop;
+    guint producers;
+    guint commands;
+    guint *next_seq;     // Expected seq per producer, main thread only
+    guint order_errors;
+    guint received;
+    gint64 *latencies;
+    gint64 max_push_us;  // Slowest single push across producers
+    GMutex push_lock;    // Only guards max_push_us, never held while pushing
+} TestState;
+
+typedef struct {
+    TestState *state;
+    guint producer;
+    guint seq;
+    gint64 push_time;
+} Payload;
+
+typedef struct {
+    TestState *state;
+    guint id;
+} ProducerArgs;
+
+static gint compare_gint64(gconstpointer a, gconstpointer b) {
+    gint64 x = *(const gint64 *)a;
+    gint64 y = *(const gint64 *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static gboolean on_timeout_quit(gpointer user_data) {
+    g_print("Timed out\n");
+    g_main_loop_quit((GMainLoop *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_command(gpointer user_data) {
+    Payload *payload = (Payload *)user_data;
+    TestState *state = payload->state;
+
+    if (payload->seq != state->next_seq[payload->producer]) {
+        state->order_errors++;
+    }
+    state->next_seq[payload->producer] = payload->seq + 1;
+    if (state->received < state->producers * state->commands) {
+        state->latencies[state->received] = g_get_monotonic_time() - payload->push_time;
+    }
+    state->received++;
+
+    g_free(payload);
+}
+
+static gpointer producer_thread(gpointer data) {
+    ProducerArgs *args = (ProducerArgs *)data;
+    TestState *state = args->state;
+    gint64 max_push_us = 0;
+
+    for (guint seq = 0; seq < state->commands; seq++) {
+        Payload *payload = g_new(Payload, 1);
+        gint64 push_time = g_get_monotonic_time();
+        payload->state = state;
+        payload->producer = args->id;
+        payload->seq = seq;
+        payload->push_time = push_time;
+
+        // payload belongs to the main thread once pushed
+        animation_queue_push_func(state->queue, on_command, payload);
+        max_push_us = MAX(max_push_us, g_get_monotonic_time() - push_time);
+
+        // Bursty producers, like a clicker daemon
+        if (seq % 1000 == 999) {
+            g_usleep(500);
+        }
+    }
+
+    g_mutex_lock(&state->push_lock);
+    state->max_push_us = MAX(state->max_push_us, max_push_us);
+    g_mutex_unlock(&state->push_lock);
+
+    g_free(args);
+    return NULL;
+}
+
+// Only watches for completion; draining is left to the queue's own wakeup
+static gboolean on_check(gpointer user_data) {
+    TestState *state = (TestState *)user_data;
+    guint total = state->producers * state->commands;
+
+    if (state->received >= total) {
+        g_main_loop_quit(state->loop);
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+int main(int argc, char **argv) {
+    TestState state = {0};
+
+    state.producers = argc > 1 ? (guint)atoi(argv[1]) : DEFAULT_PRODUCERS;
+    state.commands = argc > 2 ? (guint)atoi(argv[2]) : DEFAULT_COMMANDS;
+    guint total = state.producers * state.commands;
+
+    state.queue = animation_queue_new();
+    state.loop = g_main_loop_new(NULL, FALSE);
+    state.next_seq = g_new0(guint, state.producers);
+    state.latencies = g_new0(gint64, MAX(total, 1));
+    g_mutex_init(&state.push_lock);
+
+    g_print("%u producers x %u commands\n", state.producers, state.commands);
+
+    gint64 start = g_get_monotonic_time();
+    GThread **threads = g_new(GThread *, state.producers);
+    for (guint i = 0; i < state.producers; i++) {
+        ProducerArgs *args = g_new(ProducerArgs, 1);
+        args->state = &state;
+        args->id = i;
+        threads[i] = g_thread_new("producer", producer_thread, args);
+    }
+
+    g_timeout_add(CHECK_INTERVAL_MS, on_check, &state);
+    g_timeout_add_seconds(TEST_TIMEOUT_S, on_timeout_quit, state.loop);
+    if (total > 0) {
+        g_main_loop_run(state.loop);
+    }
+
+    for (guint i = 0; i < state.producers; i++) {
+        g_thread_join(threads[i]);
+    }
+    double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+    // Nothing may be left over or run twice
+    guint leftover = animation_queue_drain(state.queue);
+
+    guint samples = MIN(state.received, total);
+    qsort(state.latencies, samples, sizeof(gint64), compare_gint64);
+    gint64 p50 = samples ? state.latencies[samples / 2] : 0;
+    gint64 p99 = samples ? state.latencies[(guint)(samples * 0.99)] : 0;
+    gint64 max = samples ? state.latencies[samples - 1] : 0;
+
+    g_print("Ran %u/%u commands in %.2f s (%.0f commands/sec)\n",
+            state.received, total, elapsed, elapsed > 0 ? state.received / elapsed : 0.0);
+    g_print("Push-to-run latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+            p50 / 1000.0, p99 / 1000.0, max / 1000.0);
+    g_print("Slowest single push: %" G_GINT64_FORMAT " us\n", state.max_push_us);
+    g_print("Order errors: %u, leftover after final drain: %u\n", state.order_errors, leftover);
+
+    gboolean passed = state.received == total && state.order_errors == 0 && leftover == 0;
+    g_print("%s\n", passed ? "PASS" : "FAIL");
+
+    animation_queue_free(state.queue);
+    g_main_loop_unref(state.loop);
+    g_mutex_clear(&state.push_lock);
+    g_free(threads);
+    g_free(state.next_seq);
+    g_free(state.latencies);
+
+    return passed ? 0 : 1;
+}
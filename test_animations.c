@@ -1,4 +1,5 @@
 #include "animations.h"
+#include "layer.h"
 #include <gtk/gtk.h>
 #include <adwaita.h>
 
@@ -72,8 +73,7 @@ static void on_pulse_clicked(GtkButton *button, gpointer user_data) {
     
     if (app->pulse_active) {
         g_print("Pulse animation already active, stopping...\n");
-        // Stop pulse by removing animation context
-        g_object_set_data(G_OBJECT(app->test_widget), "pulse_ctx", NULL);
+        animation_cancel(app->test_widget, ANIMATION_KIND_PULSE);
         app->pulse_active = FALSE;
         gtk_button_set_label(button, "Start Pulse");
         return;
@@ -183,8 +183,10 @@ static void setup_test_window(GtkApplication *app, gpointer user_data) {
     gtk_image_set_pixel_size(GTK_IMAGE(test_app->camera_widget), 48);
     gtk_box_append(GTK_BOX(test_area), test_app->camera_widget);
     
-    test_app->slides_widget = gtk_image_new_from_icon_name("view-paged");
-    gtk_image_set_pixel_size(GTK_IMAGE(test_app->slides_widget), 48);
+    // Slides are wrapped in a layer so camera moves composite a cached texture
+    GtkWidget *slides_image = gtk_image_new_from_icon_name("view-paged");
+    gtk_image_set_pixel_size(GTK_IMAGE(slides_image), 48);
+    test_app->slides_widget = present_layer_new(slides_image);
     gtk_box_append(GTK_BOX(test_area), test_app->slides_widget);
     
     // Apply CSS
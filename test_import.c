@@ -0,0 +1,204 @@
+#include "import.h"
+#include "test_zip.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+// Imports a minimal hand-built .pptx and .odp and checks the document
+// model: slide order, title detection, paragraphs, skipped speaker notes
+// and media paths resolved and de-duplicated.
+//
+//   ./test_import
+
+static guint failures;
+
+#define CHECK(condition, what) check((condition), (what), #condition)
+
+static void check(gboolean ok, const char *what, const char *condition) {
+    g_print("%s: %s%s%s\n", ok ? "ok" : "FAIL", what, ok ? "" : " -- ", ok ? "" : condition);
+    if (!ok) {
+        failures++;
+    }
+}
+
+static gboolean has_paragraphs(Slide *slide, const char * const *expected) {
+    guint n = g_strv_length((char **)expected);
+
+    if (slide->paragraphs->len != n) {
+        return FALSE;
+    }
+    for (guint i = 0; i < n; i++) {
+        if (g_strcmp0(g_ptr_array_index(slide->paragraphs, i), expected[i]) != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gboolean has_single_media(Slide *slide, const char *path) {
+    return slide->media->len == 1 && g_strcmp0(g_ptr_array_index(slide->media, 0), path) == 0;
+}
+
+static Deck *import_entries(const TestZipEntry *entries, guint n_entries, GError **error) {
+    GByteArray *zip = test_zip_build(entries, n_entries);
+    char *path = test_zip_write_tmp(zip->data, zip->len, error);
+    Deck *deck = NULL;
+
+    if (path) {
+        // The archive stays mapped after the file is unlinked
+        deck = import_deck(path, error);
+        g_unlink(path);
+        g_free(path);
+    }
+
+    g_byte_array_unref(zip);
+    return deck;
+}
+
+static void test_pptx(void) {
+    // Presentation order is the reverse of the part names
+    static const TestZipEntry entries[] = {
+        { "ppt/presentation.xml",
+          "<p:presentation><p:sldIdLst>"
+          "<p:sldId id=\"256\" r:id=\"rId3\"/>"
+          "<p:sldId id=\"257\" r:id=\"rId2\"/>"
+          "</p:sldIdLst></p:presentation>", TRUE, 0 },
+        { "ppt/_rels/presentation.xml.rels",
+          "<Relationships>"
+          "<Relationship Id=\"rId1\" Target=\"theme/theme1.xml\"/>"
+          "<Relationship Id=\"rId2\" Target=\"slides/slide1.xml\"/>"
+          "<Relationship Id=\"rId3\" Target=\"/ppt/slides/slide2.xml\"/>"
+          "</Relationships>", TRUE, 0 },
+        { "ppt/slides/slide1.xml",
+          "<p:sld><p:cSld><p:spTree>"
+          "<p:sp><p:nvSpPr><p:nvPr><p:ph type=\"title\"/></p:nvPr></p:nvSpPr>"
+          "<p:txBody><a:p><a:r><a:t>Quarterly</a:t></a:r><a:br/><a:r><a:t>Review</a:t></a:r></a:p>"
+          "</p:txBody></p:sp>"
+          "<p:sp><p:txBody><a:p><a:r><a:t>Revenue up</a:t></a:r></a:p>"
+          "<a:p><a:r><a:t>  </a:t></a:r></a:p>"
+          "<a:p><a:r><a:t>Costs down</a:t></a:r></a:p></p:txBody></p:sp>"
+          "<p:pic><p:blipFill><a:blip r:embed=\"rId2\"/></p:blipFill></p:pic>"
+          "<p:pic><p:blipFill><a:blip r:embed=\"rId3\"/></p:blipFill></p:pic>"
+          "<p:pic><p:blipFill><a:blip r:embed=\"rId9\"/></p:blipFill></p:pic>"
+          "</p:spTree></p:cSld></p:sld>", TRUE, 0 },
+        { "ppt/slides/_rels/slide1.xml.rels",
+          "<Relationships>"
+          "<Relationship Id=\"rId2\" Target=\"../media/image1.png\"/>"
+          "<Relationship Id=\"rId3\" Target=\"./../slides/../media/image1.png\"/>"
+          "<Relationship Id=\"rId9\" Target=\"http://example.com/a.png\" TargetMode=\"External\"/>"
+          "</Relationships>", TRUE, 0 },
+        { "ppt/slides/slide2.xml",
+          "<p:sld><p:cSld><p:spTree>"
+          "<p:sp><p:txBody><a:p><a:r><a:t>Agenda</a:t></a:r></a:p>"
+          "<a:p><a:r><a:t>Intro</a:t></a:r></a:p></p:txBody></p:sp>"
+          "</p:spTree></p:cSld></p:sld>", TRUE, 0 },
+        { "ppt/media/image1.png", "not decoded by the importer", FALSE, 0 },
+    };
+    static const char * const first_text[] = { "Agenda", "Intro", NULL };
+    static const char * const second_text[] = { "Quarterly Review", "Revenue up", "Costs down", NULL };
+    GError *error = NULL;
+
+    Deck *deck = import_entries(entries, G_N_ELEMENTS(entries), &error);
+    CHECK(deck != NULL, "pptx imports");
+    if (!deck) {
+        g_print("  %s\n", error ? error->message : "no error");
+        g_clear_error(&error);
+        return;
+    }
+
+    CHECK(deck->slides->len == 2, "pptx has both slides");
+    if (deck->slides->len == 2) {
+        Slide *first = g_ptr_array_index(deck->slides, 0);
+        Slide *second = g_ptr_array_index(deck->slides, 1);
+
+        CHECK(first->index == 0 && second->index == 1, "pptx slides are indexed in presentation order");
+        CHECK(g_strcmp0(first->title, "Agenda") == 0,
+              "pptx slide without a title placeholder falls back to its first paragraph");
+        CHECK(has_paragraphs(first, first_text), "pptx absolute relationship target resolves");
+        CHECK(g_strcmp0(second->title, "Quarterly Review") == 0,
+              "pptx title placeholder becomes the title, line breaks as spaces");
+        CHECK(has_paragraphs(second, second_text), "pptx paragraphs in order, blank ones dropped");
+        CHECK(has_single_media(second, "ppt/media/image1.png"),
+              "pptx relative image targets resolve and de-duplicate, external ones are skipped");
+        CHECK(first->media->len == 0, "pptx slide without images has no media");
+    }
+
+    CHECK(deck_get_media(deck, "ppt/media/image1.png") != NULL, "pptx media is registered with the deck");
+
+    deck_free(deck);
+}
+
+static void test_odp(void) {
+    static const TestZipEntry entries[] = {
+        { "mimetype", "application/vnd.oasis.opendocument.presentation", FALSE, 0 },
+        { "content.xml",
+          "<office:document-content><office:body><office:presentation>"
+          "<draw:page draw:name=\"one\">"
+          "<draw:frame presentation:class=\"title\"><draw:text-box>"
+          "<text:p>Welcome</text:p></draw:text-box></draw:frame>"
+          "<draw:frame presentation:class=\"outline\"><draw:text-box>"
+          "<text:p>First<text:s/>point</text:p>"
+          "<text:p><text:span>Second</text:span> point</text:p>"
+          "</draw:text-box></draw:frame>"
+          "<draw:frame><draw:image xlink:href=\"Pictures/a.png\"/></draw:frame>"
+          "<draw:frame><draw:image xlink:href=\"./Pictures/a.png\"/></draw:frame>"
+          "<draw:frame><draw:image xlink:href=\"https://example.com/b.png\"/></draw:frame>"
+          "<presentation:notes><draw:frame><draw:text-box>"
+          "<text:p>Speaker only</text:p></draw:text-box></draw:frame></presentation:notes>"
+          "</draw:page>"
+          "<draw:page draw:name=\"two\"><draw:frame><draw:text-box>"
+          "<text:h>Body heading</text:h></draw:text-box></draw:frame></draw:page>"
+          "</office:presentation></office:body></office:document-content>", TRUE, 0 },
+        { "Pictures/a.png", "not decoded by the importer", FALSE, 0 },
+    };
+    static const char * const first_text[] = { "Welcome", "First point", "Second point", NULL };
+    static const char * const second_text[] = { "Body heading", NULL };
+    GError *error = NULL;
+
+    Deck *deck = import_entries(entries, G_N_ELEMENTS(entries), &error);
+    CHECK(deck != NULL, "odp imports");
+    if (!deck) {
+        g_print("  %s\n", error ? error->message : "no error");
+        g_clear_error(&error);
+        return;
+    }
+
+    CHECK(deck->slides->len == 2, "odp has both pages");
+    if (deck->slides->len == 2) {
+        Slide *first = g_ptr_array_index(deck->slides, 0);
+        Slide *second = g_ptr_array_index(deck->slides, 1);
+
+        CHECK(g_strcmp0(first->title, "Welcome") == 0, "odp title frame becomes the title");
+        CHECK(has_paragraphs(first, first_text), "odp paragraphs in order, speaker notes skipped");
+        CHECK(has_single_media(first, "Pictures/a.png"),
+              "odp image paths resolve and de-duplicate, remote ones are skipped");
+        CHECK(g_strcmp0(second->title, "Body heading") == 0,
+              "odp page without a title frame falls back to its first paragraph");
+        CHECK(has_paragraphs(second, second_text), "odp headings count as paragraphs");
+    }
+
+    deck_free(deck);
+}
+
+static void test_not_a_presentation(void) {
+    static const TestZipEntry entries[] = {
+        { "word/document.xml", "<w:document/>", TRUE, 0 },
+    };
+    GError *error = NULL;
+
+    Deck *deck = import_entries(entries, G_N_ELEMENTS(entries), &error);
+    CHECK(!deck && error, "archive without presentation parts is rejected");
+
+    g_clear_error(&error);
+    if (deck) {
+        deck_free(deck);
+    }
+}
+
+int main(int argc, char **argv) {
+    test_pptx();
+    test_odp();
+    test_not_a_presentation();
+
+    g_print("%s: %u failures\n", failures == 0 ? "PASS" : "FAIL", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include "memory_budget.h"
+
+// Drives the memory budget with two fake caches whose evict callbacks free
+// exactly down to the requested target. Checks per-cache budgets, trimming
+// to the global limit largest cache first, deferred versus headless inline
+// enforcement and the low memory shrink levels, and that usage never wraps
+// below zero.
+//
+//   ./test_memory_budget
+
+#define LARGE_LIMIT (1024 * 1024 * 1024)
+#define LARGE_BUDGET (1024 * 1024 * 1024)
+
+typedef struct {
+    MemoryAccount *account;
+    guint evictions;
+} FakeCache;
+
+static guint failures;
+
+#define CHECK(condition, what) check((condition), (what), #condition)
+
+static void check(gboolean ok, const char *what, const char *condition) {
+    g_print("%s: %s%s%s\n", ok ? "ok" : "FAIL", what, ok ? "" : " -- ", ok ? "" : condition);
+    if (!ok) {
+        failures++;
+    }
+}
+
+static void fake_evict(MemoryAccount *account, gsize target_bytes, gpointer user_data) {
+    FakeCache *cache = (FakeCache *)user_data;
+    gsize usage = memory_account_get_usage(account);
+
+    cache->evictions++;
+    if (usage > target_bytes) {
+        memory_account_add(account, -(gssize)(usage - target_bytes));
+    }
+}
+
+static void fake_register(FakeCache *cache, const char *name, gsize budget) {
+    cache->evictions = 0;
+    cache->account = memory_account_register(name, budget, fake_evict, cache);
+}
+
+static void fake_unregister(FakeCache *cache) {
+    memory_account_unregister(cache->account);
+    cache->account = NULL;
+}
+
+static gsize usage_of(FakeCache *cache) {
+    return memory_account_get_usage(cache->account);
+}
+
+static void test_account_budget(void) {
+    FakeCache a, b;
+
+    memory_budget_set_headless(TRUE);
+    memory_budget_set_limit(LARGE_LIMIT);
+    fake_register(&a, "a", 1000);
+    fake_register(&b, "b", 5000);
+
+    memory_account_add(a.account, 800);
+    memory_account_add(b.account, 4000);
+    CHECK(a.evictions == 0 && b.evictions == 0, "caches within budget are left alone");
+
+    memory_account_add(a.account, 400);
+    CHECK(usage_of(&a) == 1000, "cache over its budget is evicted down to it");
+    CHECK(usage_of(&b) == 4000 && b.evictions == 0, "cache within its budget is untouched");
+    CHECK(memory_budget_get_usage() == 5000, "total follows the evicted bytes");
+
+    fake_unregister(&a);
+    fake_unregister(&b);
+    CHECK(memory_budget_get_usage() == 0, "unregistering releases the remaining usage");
+}
+
+static void test_global_limit(void) {
+    FakeCache a, b;
+
+    memory_budget_set_headless(TRUE);
+    memory_budget_set_limit(10000);
+    fake_register(&a, "a", LARGE_BUDGET);
+    fake_register(&b, "b", LARGE_BUDGET);
+
+    memory_account_add(a.account, 3000);
+    memory_account_add(b.account, 7000);
+    CHECK(a.evictions == 0 && b.evictions == 0, "caches exactly at the limit are left alone");
+
+    memory_account_add(a.account, 2000);
+    CHECK(usage_of(&b) == 5000, "largest cache is trimmed by the excess");
+    CHECK(usage_of(&a) == 5000 && a.evictions == 0, "smaller cache is untouched once the total fits");
+
+    // Excess is larger than either cache: the first goes to zero, not below
+    memory_budget_set_limit(1000);
+    gsize low = MIN(usage_of(&a), usage_of(&b));
+    gsize high = MAX(usage_of(&a), usage_of(&b));
+    CHECK(low == 0 && high == 1000, "caches are trimmed in turn until the total fits");
+    CHECK(memory_budget_get_usage() == 1000, "total matches the limit after trimming");
+
+    memory_budget_set_limit(LARGE_LIMIT);
+    fake_unregister(&a);
+    fake_unregister(&b);
+    CHECK(memory_budget_get_usage() == 0, "total returns to zero, never wraps below it");
+}
+
+static void test_deferred_enforce(void) {
+    FakeCache a;
+
+    memory_budget_set_headless(FALSE);
+    fake_register(&a, "a", 1000);
+
+    memory_account_add(a.account, 2000);
+    CHECK(usage_of(&a) == 2000 && a.evictions == 0, "with a main loop eviction waits for an idle");
+
+    while (g_main_context_iteration(NULL, FALSE)) {
+    }
+    CHECK(usage_of(&a) == 1000 && a.evictions == 1, "idle evicts once the main loop runs");
+
+    memory_budget_set_headless(TRUE);
+    memory_account_add(a.account, 2000);
+    CHECK(usage_of(&a) == 1000 && a.evictions == 2, "headless mode evicts inline");
+
+    fake_unregister(&a);
+}
+
+static void test_shrink_levels(void) {
+    FakeCache a, b;
+
+    memory_budget_set_headless(TRUE);
+    fake_register(&a, "a", LARGE_BUDGET);
+    fake_register(&b, "b", LARGE_BUDGET);
+    memory_account_add(a.account, 1000);
+    memory_account_add(b.account, 2000);
+
+    memory_budget_shrink(G_MEMORY_MONITOR_WARNING_LEVEL_LOW);
+    CHECK(usage_of(&a) == 500 && usage_of(&b) == 1000, "low warning keeps half of every cache");
+
+    memory_budget_shrink(G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM);
+    CHECK(usage_of(&a) == 125 && usage_of(&b) == 250, "medium warning keeps a quarter");
+
+    memory_budget_shrink(G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL);
+    CHECK(usage_of(&a) == 0 && usage_of(&b) == 0, "critical warning empties every cache");
+
+    guint evictions = a.evictions + b.evictions;
+    memory_budget_shrink(G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL);
+    CHECK(a.evictions + b.evictions == evictions, "empty caches are not asked to evict again");
+    CHECK(memory_budget_get_usage() == 0, "shrinking never drives the total below zero");
+
+    fake_unregister(&a);
+    fake_unregister(&b);
+}
+
+int main(int argc, char **argv) {
+    test_account_budget();
+    test_global_limit();
+    test_deferred_enforce();
+    test_shrink_levels();
+
+    g_print("%s: %u failures\n", failures == 0 ? "PASS" : "FAIL", failures);
+    return failures == 0 ? 0 : 1;
+}
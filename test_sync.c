@@ -0,0 +1,214 @@
+#include "sync.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+// Runs one leader in this process and several follower processes (this
+// same binary re-executed with --follow), then reports the advance latency
+// each follower measured.
+//
+// The first follower applies positions on a real window's frame clock, so
+// its end-to-end figure covers transport plus presentation-time
+// compensation. The others apply positions on arrival and only report
+// transport latency. Without a display every follower falls back to the
+// latter.
+//
+//   ./test_sync [followers] [advances]
+
+#define DEFAULT_FOLLOWERS 4
+#define DEFAULT_ADVANCES 200
+#define ADVANCE_INTERVAL_MS 10
+#define TEST_TIMEOUT_MS 20000
+
+typedef struct {
+    GMainLoop *loop;
+    guint final_slide;
+    guint last_slide;
+    guint updates;
+    gboolean out_of_order;
+} FollowerState;
+
+typedef struct {
+    GMainLoop *loop;
+    SyncLeader *leader;
+    guint followers;
+    guint advances;
+    guint next_slide;
+    guint finished;
+    guint failed;
+} LeaderState;
+
+static void on_follower_position(guint slide, gint64 timeline_us, gpointer user_data) {
+    FollowerState *state = (FollowerState *)user_data;
+
+    // Stale positions must never be applied after newer ones
+    if (state->updates > 0 && slide < state->last_slide) {
+        state->out_of_order = TRUE;
+    }
+    state->last_slide = slide;
+    state->updates++;
+
+    if (slide == state->final_slide) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+static gboolean on_timeout_quit(gpointer user_data) {
+    g_print("Timed out\n");
+    g_main_loop_quit((GMainLoop *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static int run_follower(const char *address, guint final_slide, gboolean use_clock) {
+    FollowerState state = {0};
+    GtkWidget *window = NULL;
+    GError *error = NULL;
+
+    state.loop = g_main_loop_new(NULL, FALSE);
+    state.final_slide = final_slide;
+
+    if (use_clock && gtk_init_check()) {
+        window = gtk_window_new();
+        gtk_window_set_child(GTK_WINDOW(window), gtk_label_new("follower"));
+        gtk_window_present(GTK_WINDOW(window));
+    } else if (use_clock) {
+        g_print("No display, frame clock follower measures transport only\n");
+    }
+
+    SyncFollower *follower = sync_follower_new(address, window, on_follower_position, &state, &error);
+    if (!follower) {
+        g_print("Follower failed: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    g_timeout_add(TEST_TIMEOUT_MS, on_timeout_quit, state.loop);
+    g_main_loop_run(state.loop);
+
+    SyncLatencyStats transport, end_to_end;
+    sync_follower_get_latency(follower, &transport, &end_to_end);
+
+    g_print("RESULT pid=%d updates=%u last=%u transport(us) min=%" G_GINT64_FORMAT
+            " mean=%.1f max=%" G_GINT64_FORMAT,
+            getpid(), state.updates, state.last_slide,
+            transport.min_us, transport.mean_us, transport.max_us);
+    if (window) {
+        // Leader send until the frame carrying the position is presented
+        g_print(" end-to-end(us) mean=%.1f max=%" G_GINT64_FORMAT,
+                end_to_end.mean_us, end_to_end.max_us);
+    }
+    g_print("\n");
+
+    sync_follower_free(follower);
+    if (window) {
+        gtk_window_destroy(GTK_WINDOW(window));
+    }
+    g_main_loop_unref(state.loop);
+
+    return (state.last_slide == final_slide && !state.out_of_order) ? 0 : 1;
+}
+
+static gboolean advance_slide(gpointer user_data) {
+    LeaderState *state = (LeaderState *)user_data;
+
+    sync_leader_broadcast(state->leader, state->next_slide, 0, TRUE);
+    if (state->next_slide == state->advances) {
+        return G_SOURCE_REMOVE;
+    }
+    state->next_slide++;
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean wait_for_followers(gpointer user_data) {
+    LeaderState *state = (LeaderState *)user_data;
+
+    if (sync_leader_get_follower_count(state->leader) < state->followers) {
+        return G_SOURCE_CONTINUE;
+    }
+
+    g_print("All %u followers connected, advancing %u slides\n", state->followers, state->advances);
+    g_timeout_add(ADVANCE_INTERVAL_MS, advance_slide, state);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void on_follower_exited(GObject *source, GAsyncResult *result, gpointer user_data) {
+    LeaderState *state = (LeaderState *)user_data;
+    GSubprocess *process = G_SUBPROCESS(source);
+    char *output = NULL;
+    GError *error = NULL;
+
+    if (!g_subprocess_communicate_utf8_finish(process, result, &output, NULL, &error)) {
+        g_print("Follower failed: %s\n", error->message);
+        g_error_free(error);
+        state->failed++;
+    } else {
+        g_print("%s", output);
+        if (!g_subprocess_get_successful(process)) {
+            state->failed++;
+        }
+    }
+    g_free(output);
+
+    state->finished++;
+    if (state->finished == state->followers) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && g_strcmp0(argv[1], "--follow") == 0) {
+        return run_follower(argv[2], (guint)atoi(argv[3]),
+                            argc > 4 && g_strcmp0(argv[4], "--clock") == 0);
+    }
+
+    LeaderState state = {0};
+    GError *error = NULL;
+
+    state.followers = argc > 1 ? (guint)atoi(argv[1]) : DEFAULT_FOLLOWERS;
+    state.advances = argc > 2 ? (guint)atoi(argv[2]) : DEFAULT_ADVANCES;
+    state.next_slide = 1;
+    state.loop = g_main_loop_new(NULL, FALSE);
+
+    char *address = g_strdup_printf("unix:%s/present-sync-test-%d.sock",
+                                    g_get_tmp_dir(), getpid());
+    state.leader = sync_leader_new(address, &error);
+    if (!state.leader) {
+        g_print("Leader failed: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    char *final_slide = g_strdup_printf("%u", state.advances);
+    for (guint i = 0; i < state.followers; i++) {
+        GSubprocess *process = g_subprocess_new(G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error,
+                                                argv[0], "--follow", address, final_slide,
+                                                i == 0 ? "--clock" : NULL, NULL);
+        if (!process) {
+            g_print("Failed to spawn follower: %s\n", error->message);
+            g_clear_error(&error);
+            state.failed++;
+            state.followers = i;
+            break;
+        }
+        g_subprocess_communicate_utf8_async(process, NULL, NULL, on_follower_exited, &state);
+        g_object_unref(process);
+    }
+
+    if (state.followers > 0) {
+        g_timeout_add(10, wait_for_followers, &state);
+        g_timeout_add(TEST_TIMEOUT_MS, on_timeout_quit, state.loop);
+        g_main_loop_run(state.loop);
+    }
+
+    gboolean passed = state.failed == 0 && state.finished == state.followers;
+    g_print("%s: %u/%u followers reached slide %u\n", passed ? "PASS" : "FAIL",
+            state.finished - MIN(state.failed, state.finished), state.followers, state.advances);
+
+    sync_leader_free(state.leader);
+    g_main_loop_unref(state.loop);
+    g_free(final_slide);
+    g_free(address);
+
+    return passed ? 0 : 1;
+}
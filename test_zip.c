@@ -0,0 +1,114 @@
+#include "test_zip.h"
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static void put_u16(GByteArray *out, guint16 value) {
+    guint8 bytes[2] = { value & 0xFF, value >> 8 };
+    g_byte_array_append(out, bytes, 2);
+}
+
+static void put_u32(GByteArray *out, guint32 value) {
+    guint8 bytes[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+    g_byte_array_append(out, bytes, 4);
+}
+
+static GBytes *deflate_raw(const char *data, gsize len) {
+    z_stream stream = {0};
+    uLong bound = compressBound(len) + 16;
+    guint8 *out = g_malloc(bound);
+
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)len;
+    stream.next_out = out;
+    stream.avail_out = (uInt)bound;
+    deflate(&stream, Z_FINISH);
+    gsize out_len = stream.total_out;
+    deflateEnd(&stream);
+
+    return g_bytes_new_take(out, out_len);
+}
+
+GByteArray *test_zip_build(const TestZipEntry *entries, guint n_entries) {
+    GByteArray *zip = g_byte_array_new();
+    GByteArray *directory = g_byte_array_new();
+
+    for (guint i = 0; i < n_entries; i++) {
+        const TestZipEntry *entry = &entries[i];
+        gsize len = strlen(entry->data);
+        guint32 crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)entry->data, (uInt)len);
+        GBytes *payload = entry->deflate ? deflate_raw(entry->data, len)
+                                         : g_bytes_new_static(entry->data, len);
+        gsize payload_len = g_bytes_get_size(payload);
+        guint32 size = entry->claimed_size ? entry->claimed_size : (guint32)len;
+        guint16 method = entry->deflate ? 8 : 0;
+        guint16 name_len = (guint16)strlen(entry->name);
+        guint32 offset = zip->len;
+
+        put_u32(zip, 0x04034b50);
+        put_u16(zip, 20);
+        put_u16(zip, 0);
+        put_u16(zip, method);
+        put_u32(zip, 0); // time, date
+        put_u32(zip, crc);
+        put_u32(zip, (guint32)payload_len);
+        put_u32(zip, size);
+        put_u16(zip, name_len);
+        put_u16(zip, 0);
+        g_byte_array_append(zip, (const guint8 *)entry->name, name_len);
+        g_byte_array_append(zip, g_bytes_get_data(payload, NULL), payload_len);
+
+        put_u32(directory, 0x02014b50);
+        put_u16(directory, 20);
+        put_u16(directory, 20);
+        put_u16(directory, 0);
+        put_u16(directory, method);
+        put_u32(directory, 0);
+        put_u32(directory, crc);
+        put_u32(directory, (guint32)payload_len);
+        put_u32(directory, size);
+        put_u16(directory, name_len);
+        put_u16(directory, 0);
+        put_u16(directory, 0);
+        put_u16(directory, 0);
+        put_u16(directory, 0);
+        put_u32(directory, 0);
+        put_u32(directory, offset);
+        g_byte_array_append(directory, (const guint8 *)entry->name, name_len);
+
+        g_bytes_unref(payload);
+    }
+
+    guint32 directory_offset = zip->len;
+    g_byte_array_append(zip, directory->data, directory->len);
+
+    put_u32(zip, 0x06054b50);
+    put_u16(zip, 0);
+    put_u16(zip, 0);
+    put_u16(zip, (guint16)n_entries);
+    put_u16(zip, (guint16)n_entries);
+    put_u32(zip, directory->len);
+    put_u32(zip, directory_offset);
+    put_u16(zip, 0);
+
+    g_byte_array_unref(directory);
+    return zip;
+}
+
+char *test_zip_write_tmp(const guint8 *data, gsize len, GError **error) {
+    char *path = NULL;
+    int fd = g_file_open_tmp("present-zip-test-XXXXXX.zip", &path, error);
+    if (fd < 0) {
+        return NULL;
+    }
+    close(fd);
+
+    if (!g_file_set_contents(path, (const char *)data, len, error)) {
+        g_unlink(path);
+        g_free(path);
+        return NULL;
+    }
+    return path;
+}
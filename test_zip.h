@@ -0,0 +1,23 @@
+#ifndef TEST_ZIP_H
+#define TEST_ZIP_H
+
+#include <glib.h>
+
+// Builds small zip archives in memory for the tests that feed the zip
+// reader and the importer. Not part of the application.
+
+typedef struct {
+    const char *name;
+    const char *data;
+    gboolean deflate;
+    guint32 claimed_size; // Uncompressed size to record instead of the real one, 0 for real
+} TestZipEntry;
+
+// Local headers and data, then the central directory and end record
+GByteArray *test_zip_build(const TestZipEntry *entries, guint n_entries);
+
+// Writes data to a new temporary .zip file and returns its path; the
+// caller unlinks and frees it
+char *test_zip_write_tmp(const guint8 *data, gsize len, GError **error);
+
+#endif
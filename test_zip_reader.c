@@ -0,0 +1,183 @@
+#include "zip_reader.h"
+#include "test_zip.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+// Feeds the zip reader hand-built archives: a good one with deflated and
+// stored entries, truncated and corrupt ones, and entries claiming sizes
+// past the inflate limit. Every malformed archive must fail cleanly with
+// an error rather than crash or allocate the claimed size.
+//
+//   ./test_zip_reader
+
+#define OVERSIZE_ENTRY (600u * 1024 * 1024)
+
+static guint failures;
+
+#define CHECK(condition, what) check((condition), (what), #condition)
+
+static void check(gboolean ok, const char *what, const char *condition) {
+    g_print("%s: %s%s%s\n", ok ? "ok" : "FAIL", what, ok ? "" : " -- ", ok ? "" : condition);
+    if (!ok) {
+        failures++;
+    }
+}
+
+static ZipReader *open_bytes(const guint8 *data, gsize len, GError **error) {
+    char *path = test_zip_write_tmp(data, len, error);
+    if (!path) {
+        return NULL;
+    }
+
+    // The mapping stays valid after the file is unlinked
+    ZipReader *reader = zip_reader_open(path, error);
+
+    g_unlink(path);
+    g_free(path);
+    return reader;
+}
+
+static gboolean bytes_equal(GBytes *bytes, const char *expected) {
+    gsize size;
+    const char *data = g_bytes_get_data(bytes, &size);
+    return size == strlen(expected) && memcmp(data, expected, size) == 0;
+}
+
+static void test_good_archive(void) {
+    static const TestZipEntry entries[] = {
+        { "content.xml", "<office:document><office:body>Hello slides</office:body></office:document>",
+          TRUE, 0 },
+        { "media/image.txt", "stored bytes, not compressed", FALSE, 0 },
+    };
+    GByteArray *zip = test_zip_build(entries, G_N_ELEMENTS(entries));
+    GError *error = NULL;
+
+    ZipReader *reader = open_bytes(zip->data, zip->len, &error);
+    CHECK(reader != NULL, "good archive opens");
+    if (!reader) {
+        g_clear_error(&error);
+        g_byte_array_unref(zip);
+        return;
+    }
+
+    CHECK(zip_reader_get_entries(reader)->len == 2, "good archive lists both entries");
+
+    GBytes *content = zip_reader_read_by_name(reader, "content.xml", &error);
+    CHECK(content && bytes_equal(content, entries[0].data), "deflated entry round-trips");
+    g_clear_error(&error);
+
+    GBytes *stored = zip_reader_read_by_name(reader, "media/image.txt", &error);
+    CHECK(stored && bytes_equal(stored, entries[1].data), "stored entry round-trips");
+    g_clear_error(&error);
+
+    GBytes *missing = zip_reader_read_by_name(reader, "missing.xml", &error);
+    CHECK(!missing && g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT),
+          "missing entry reports NOENT");
+    g_clear_error(&error);
+
+    // Stored bytes point into the mapping and must keep it alive
+    zip_reader_unref(reader);
+    CHECK(stored && bytes_equal(stored, entries[1].data), "stored entry outlives the reader");
+
+    g_clear_pointer(&content, g_bytes_unref);
+    g_clear_pointer(&stored, g_bytes_unref);
+    g_byte_array_unref(zip);
+}
+
+static void test_stored_size_mismatch(void) {
+    static const TestZipEntry entries[] = {
+        { "media/image.txt", "short", FALSE, 4096 },
+    };
+    GByteArray *zip = test_zip_build(entries, G_N_ELEMENTS(entries));
+    GError *error = NULL;
+
+    ZipReader *reader = open_bytes(zip->data, zip->len, &error);
+    GBytes *bytes = reader ? zip_reader_read_by_name(reader, "media/image.txt", &error) : NULL;
+    CHECK(reader && !bytes && error, "stored entry with mismatched sizes is rejected");
+
+    g_clear_error(&error);
+    g_clear_pointer(&bytes, g_bytes_unref);
+    zip_reader_unref(reader);
+    g_byte_array_unref(zip);
+}
+
+static void test_truncated_archive(void) {
+    static const TestZipEntry entries[] = {
+        { "content.xml", "<document>some text that will be cut off</document>", TRUE, 0 },
+    };
+    GByteArray *zip = test_zip_build(entries, G_N_ELEMENTS(entries));
+    GError *error = NULL;
+
+    // Cut through the entry data: the end record is gone
+    ZipReader *reader = open_bytes(zip->data, zip->len / 2, &error);
+    CHECK(!reader && error, "archive truncated mid-entry fails to open");
+    g_clear_error(&error);
+    zip_reader_unref(reader);
+
+    reader = open_bytes(zip->data, 10, &error);
+    CHECK(!reader && error, "archive shorter than an end record fails to open");
+    g_clear_error(&error);
+    zip_reader_unref(reader);
+
+    // Directory intact but the entry claims more data than the file holds
+    guint8 *copy = g_memdup2(zip->data, zip->len);
+    gsize directory = zip->len - 22 - (46 + strlen(entries[0].name));
+    copy[directory + 20] = 0xFF;
+    copy[directory + 21] = 0xFF;
+    reader = open_bytes(copy, zip->len, &error);
+    GBytes *bytes = reader ? zip_reader_read_by_name(reader, "content.xml", &error) : NULL;
+    CHECK(reader && !bytes && error, "entry running past the end of the file is rejected");
+    g_clear_error(&error);
+    g_clear_pointer(&bytes, g_bytes_unref);
+    zip_reader_unref(reader);
+
+    // Corrupt compressed payload must fail inflate or the CRC check
+    memcpy(copy, zip->data, zip->len);
+    gsize payload = 30 + strlen(entries[0].name);
+    copy[payload + 2] ^= 0x5A;
+    copy[payload + 3] ^= 0xA5;
+    reader = open_bytes(copy, zip->len, &error);
+    bytes = reader ? zip_reader_read_by_name(reader, "content.xml", &error) : NULL;
+    CHECK(reader && !bytes && error, "corrupt deflate data is rejected");
+    g_clear_error(&error);
+    g_clear_pointer(&bytes, g_bytes_unref);
+    zip_reader_unref(reader);
+
+    g_free(copy);
+    g_byte_array_unref(zip);
+}
+
+static void test_oversize_entry(void) {
+    static const TestZipEntry entries[] = {
+        { "ppt/slides/slide1.xml", "<bomb/>", TRUE, OVERSIZE_ENTRY },
+        { "media/huge.bin", "tiny", FALSE, OVERSIZE_ENTRY },
+    };
+    GByteArray *zip = test_zip_build(entries, G_N_ELEMENTS(entries));
+    GError *error = NULL;
+
+    ZipReader *reader = open_bytes(zip->data, zip->len, &error);
+    CHECK(reader != NULL, "archive with oversize entries opens");
+
+    for (guint i = 0; reader && i < G_N_ELEMENTS(entries); i++) {
+        GBytes *bytes = zip_reader_read_by_name(reader, entries[i].name, &error);
+        CHECK(!bytes && g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_FBIG),
+              entries[i].deflate ? "oversize deflated entry reports FBIG"
+                                 : "oversize stored entry reports FBIG");
+        g_clear_error(&error);
+        g_clear_pointer(&bytes, g_bytes_unref);
+    }
+
+    g_clear_error(&error);
+    zip_reader_unref(reader);
+    g_byte_array_unref(zip);
+}
+
+int main(int argc, char **argv) {
+    test_good_archive();
+    test_stored_size_mismatch();
+    test_truncated_archive();
+    test_oversize_entry();
+
+    g_print("%s: %u failures\n", failures == 0 ? "PASS" : "FAIL", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+#include "zip_reader.h"
+#include <string.h>
+#include <zlib.h>
+
+#define ZIP_LOCAL_HEADER_SIG   0x04034b50
+#define ZIP_CENTRAL_HEADER_SIG 0x02014b50
+#define ZIP_END_RECORD_SIG     0x06054b50
+
+#define ZIP_LOCAL_HEADER_SIZE   30
+#define ZIP_CENTRAL_HEADER_SIZE 46
+#define ZIP_END_RECORD_SIZE     22
+#define ZIP_MAX_COMMENT         0xFFFF
+
+#define ZIP_METHOD_STORED   0
+#define ZIP_METHOD_DEFLATED 8
+
+// Refuse to inflate anything larger, protects against zip bombs
+#define ZIP_MAX_ENTRY_SIZE (512 * 1024 * 1024)
+
+struct _ZipReader {
+    gint ref_count;
+    GMappedFile *file;
+    const guint8 *data;
+    gsize size;
+    GPtrArray *entries; // ZipEntry*
+    GHashTable *by_name;
+};
+
+// Static helper functions
+static guint16 read_u16(const guint8 *p);
+static guint32 read_u32(const guint8 *p);
+static gboolean parse_central_directory(ZipReader *reader, GError **error);
+static void free_entry(ZipEntry *entry);
+
+static guint16 read_u16(const guint8 *p) {
+    return (guint16)(p[0] | (p[1] << 8));
+}
+
+static guint32 read_u32(const guint8 *p) {
+    return (guint32)p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+}
+
+static void free_entry(ZipEntry *entry) {
+    if (entry) {
+        g_free(entry->name);
+        g_free(entry);
+    }
+}
+
+ZipReader *zip_reader_open(const char *path, GError **error) {
+    GMappedFile *file = g_mapped_file_new(path, FALSE, error);
+    if (!file) {
+        return NULL;
+    }
+
+    ZipReader *reader = g_new0(ZipReader, 1);
+    reader->ref_count = 1;
+    reader->file = file;
+    reader->data = (const guint8 *)g_mapped_file_get_contents(file);
+    reader->size = g_mapped_file_get_length(file);
+    reader->entries = g_ptr_array_new_with_free_func((GDestroyNotify)free_entry);
+    reader->by_name = g_hash_table_new(g_str_hash, g_str_equal);
+
+    if (!parse_central_directory(reader, error)) {
+        g_prefix_error(error, "%s: ", path);
+        zip_reader_unref(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+static gboolean parse_central_directory(ZipReader *reader, GError **error) {
+    if (reader->size < ZIP_END_RECORD_SIZE) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Not a zip archive");
+        return FALSE;
+    }
+
+    // The end record sits at the very end, followed only by an optional comment
+    const guint8 *end_record = NULL;
+    gsize search_limit = MIN(reader->size, ZIP_END_RECORD_SIZE + ZIP_MAX_COMMENT);
+    for (gsize back = ZIP_END_RECORD_SIZE; back <= search_limit; back++) {
+        const guint8 *p = reader->data + reader->size - back;
+        if (read_u32(p) == ZIP_END_RECORD_SIG) {
+            end_record = p;
+            break;
+        }
+    }
+
+    if (!end_record) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Not a zip archive");
+        return FALSE;
+    }
+
+    guint16 count = read_u16(end_record + 10);
+    guint32 dir_size = read_u32(end_record + 12);
+    guint32 dir_offset = read_u32(end_record + 16);
+
+    if (dir_offset == 0xFFFFFFFF || count == 0xFFFF) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Zip64 archives are not supported");
+        return FALSE;
+    }
+    if ((guint64)dir_offset + dir_size > reader->size) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Truncated zip central directory");
+        return FALSE;
+    }
+
+    const guint8 *p = reader->data + dir_offset;
+    const guint8 *dir_end = p + dir_size;
+
+    for (guint i = 0; i < count; i++) {
+        if (p + ZIP_CENTRAL_HEADER_SIZE > dir_end || read_u32(p) != ZIP_CENTRAL_HEADER_SIG) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Corrupt zip central directory");
+            return FALSE;
+        }
+
+        guint16 name_len = read_u16(p + 28);
+        guint16 extra_len = read_u16(p + 30);
+        guint16 comment_len = read_u16(p + 32);
+        if (p + ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len > dir_end) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Corrupt zip central directory");
+            return FALSE;
+        }
+
+        ZipEntry *entry = g_new0(ZipEntry, 1);
+        entry->method = read_u16(p + 10);
+        entry->crc32 = read_u32(p + 16);
+        entry->compressed_size = read_u32(p + 20);
+        entry->uncompressed_size = read_u32(p + 24);
+        entry->local_header_offset = read_u32(p + 42);
+        entry->name = g_strndup((const char *)p + ZIP_CENTRAL_HEADER_SIZE, name_len);
+
+        g_ptr_array_add(reader->entries, entry);
+        g_hash_table_insert(reader->by_name, entry->name, entry);
+
+        p += ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len;
+    }
+
+    return TRUE;
+}
+
+ZipReader *zip_reader_ref(ZipReader *reader) {
+    g_atomic_int_inc(&reader->ref_count);
+    return reader;
+}
+
+void zip_reader_unref(ZipReader *reader) {
+    if (reader && g_atomic_int_dec_and_test(&reader->ref_count)) {
+        g_hash_table_destroy(reader->by_name);
+        g_ptr_array_unref(reader->entries);
+        g_mapped_file_unref(reader->file);
+        g_free(reader);
+    }
+}
+
+const GPtrArray *zip_reader_get_entries(ZipReader *reader) {
+    return reader->entries;
+}
+
+const ZipEntry *zip_reader_find(ZipReader *reader, const char *name) {
+    return g_hash_table_lookup(reader->by_name, name);
+}
+
+GBytes *zip_reader_read(ZipReader *reader, const ZipEntry *entry, GError **error) {
+    guint64 header = entry->local_header_offset;
+
+    if (header + ZIP_LOCAL_HEADER_SIZE > reader->size ||
+        read_u32(reader->data + header) != ZIP_LOCAL_HEADER_SIG) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Corrupt zip entry '%s'", entry->name);
+        return NULL;
+    }
+
+    // Local name/extra lengths may differ from the central directory copy
+    guint64 offset = header + ZIP_LOCAL_HEADER_SIZE +
+                     read_u16(reader->data + header + 26) +
+                     read_u16(reader->data + header + 28);
+    if (offset + entry->compressed_size > reader->size) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Truncated zip entry '%s'", entry->name);
+        return NULL;
+    }
+    const guint8 *compressed = reader->data + offset;
+
+    if (entry->uncompressed_size > ZIP_MAX_ENTRY_SIZE) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FBIG, "Zip entry '%s' is too large", entry->name);
+        return NULL;
+    }
+
+    if (entry->method == ZIP_METHOD_STORED) {
+        if (entry->compressed_size != entry->uncompressed_size) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Corrupt zip entry '%s'", entry->name);
+            return NULL;
+        }
+        // Keep the mapping alive for as long as the bytes are referenced
+        return g_bytes_new_with_free_func(compressed, entry->compressed_size,
+                                          (GDestroyNotify)zip_reader_unref,
+                                          zip_reader_ref(reader));
+    }
+
+    if (entry->method != ZIP_METHOD_DEFLATED) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                    "Unsupported compression method %u for '%s'", entry->method, entry->name);
+        return NULL;
+    }
+
+    z_stream stream = {0};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOMEM, "Failed to initialise inflate");
+        return NULL;
+    }
+
+    guint8 *out = g_malloc(MAX(entry->uncompressed_size, 1));
+    stream.next_in = (Bytef *)compressed;
+    stream.avail_in = (uInt)entry->compressed_size;
+    stream.next_out = out;
+    stream.avail_out = (uInt)entry->uncompressed_size;
+
+    int ret = inflate(&stream, Z_FINISH);
+    gboolean ok = ret == Z_STREAM_END && stream.total_out == entry->uncompressed_size;
+    inflateEnd(&stream);
+
+    if (ok && crc32(crc32(0L, Z_NULL, 0), out, (uInt)entry->uncompressed_size) != entry->crc32) {
+        ok = FALSE;
+    }
+
+    if (!ok) {
+        g_free(out);
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Corrupt compressed data in '%s'", entry->name);
+        return NULL;
+    }
+
+    return g_bytes_new_take(out, entry->uncompressed_size);
+}
+
+GBytes *zip_reader_read_by_name(ZipReader *reader, const char *name, GError **error) {
+    const ZipEntry *entry = zip_reader_find(reader, name);
+    if (!entry) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOENT, "No '%s' in archive", name);
+        return NULL;
+    }
+    return zip_reader_read(reader, entry, error);
+}
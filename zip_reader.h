@@ -0,0 +1,33 @@
+#ifndef ZIP_READER_H
+#define ZIP_READER_H
+
+#include <glib.h>
+
+// Minimal read-only zip container reader. The archive is memory mapped and
+// entries are inflated straight into memory, nothing is extracted to disk.
+// Reading different entries from several threads at once is safe.
+
+typedef struct {
+    char *name;
+    guint16 method;
+    guint32 crc32;
+    guint64 compressed_size;
+    guint64 uncompressed_size;
+    guint64 local_header_offset;
+} ZipEntry;
+
+typedef struct _ZipReader ZipReader;
+
+ZipReader *zip_reader_open(const char *path, GError **error);
+ZipReader *zip_reader_ref(ZipReader *reader);
+void zip_reader_unref(ZipReader *reader);
+
+// Entries in central directory order
+const GPtrArray *zip_reader_get_entries(ZipReader *reader);
+const ZipEntry *zip_reader_find(ZipReader *reader, const char *name);
+
+// Stored entries are returned without copying
+GBytes *zip_reader_read(ZipReader *reader, const ZipEntry *entry, GError **error);
+GBytes *zip_reader_read_by_name(ZipReader *reader, const char *name, GError **error);
+
+#endif